@@ -0,0 +1,16 @@
+#include "assets.h"
+
+#ifdef EMBED_ASSETS
+const EmbeddedAsset *find_embedded_asset(const std::string &name) {
+  for (const EmbeddedAsset *asset = embedded_assets; asset->name; asset++) {
+    if (name == asset->name) {
+      return asset;
+    }
+  }
+  return nullptr;
+}
+#else
+const EmbeddedAsset *find_embedded_asset(const std::string &) {
+  return nullptr;
+}
+#endif
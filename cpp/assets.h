@@ -0,0 +1,22 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <cstddef>
+#include <string>
+
+// Data files compiled into the executable by "make EMBED_ASSETS=1". The
+// loaders only fall back to these when no file is found on disk, so a file
+// next to the game still overrides its built-in copy.
+struct EmbeddedAsset {
+  const char *name; // Path as it is in cpp/, e.g. "audio/jump.mp3"
+  const unsigned char *data;
+  size_t size;
+};
+
+// Generated into embedded_assets.cpp; ends with a null name
+extern const EmbeddedAsset embedded_assets[];
+
+// The built-in copy of name, or nullptr if there isn't one
+const EmbeddedAsset *find_embedded_asset(const std::string &name);
+
+#endif
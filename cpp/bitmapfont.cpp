@@ -0,0 +1,109 @@
+#include "willy.h"
+
+// willy.chr only holds the game's sprites, not a character set, so the font
+// is rasterized once with Pango into an atlas of fixed-size cells. After that
+// drawing text is one rectangle fill per character and measuring it is a
+// character count.
+
+BitmapFont::BitmapFont(const std::string &family, int point_size) {
+  for (gunichar c = 32; c < 127; c++) {
+    glyphs.push_back(c);
+  }
+  // The arrows on the intro screen
+  for (gunichar c = 0x2190; c <= 0x2193; c++) {
+    glyphs.push_back(c);
+  }
+  for (size_t i = 0; i < glyphs.size(); i++) {
+    glyph_index[glyphs[i]] = i;
+  }
+
+  Pango::FontDescription font_desc;
+  font_desc.set_family(family);
+  font_desc.set_size(point_size * PANGO_SCALE);
+
+  // Monospace, so one character gives the cell for all of them
+  auto scratch = Cairo::ImageSurface::create(Cairo::FORMAT_A8, 1, 1);
+  auto layout = Pango::Layout::create(Cairo::Context::create(scratch));
+  layout->set_font_description(font_desc);
+  layout->set_text("M");
+  layout->get_pixel_size(cell_width, cell_height);
+  cell_width = std::max(1, cell_width);
+  cell_height = std::max(1, cell_height);
+
+  atlas = Cairo::ImageSurface::create(
+      Cairo::FORMAT_A8, cell_width * (int)glyphs.size(), cell_height);
+  auto cr = Cairo::Context::create(atlas);
+  layout = Pango::Layout::create(cr);
+  layout->set_font_description(font_desc);
+  cr->set_source_rgba(0.0, 0.0, 0.0, 1.0);
+
+  for (size_t i = 0; i < glyphs.size(); i++) {
+    layout->set_text(Glib::ustring(1, glyphs[i]));
+    int text_width, text_height;
+    layout->get_pixel_size(text_width, text_height);
+
+    // Anything from a fallback font is centred and clipped to the cell
+    cr->save();
+    cr->rectangle(i * cell_width, 0, cell_width, cell_height);
+    cr->clip();
+    cr->move_to(i * cell_width + (cell_width - text_width) / 2, 0);
+    layout->show_in_cairo_context(cr);
+    cr->restore();
+  }
+  atlas->flush();
+}
+
+int BitmapFont::measure(const std::string &text) const {
+  return Glib::ustring(text).size() * cell_width;
+}
+
+Cairo::RefPtr<Cairo::ImageSurface> BitmapFont::get_tinted_atlas(double r,
+                                                                double g,
+                                                                double b) {
+  uint32_t key = argb_from_rgb(r, g, b);
+  auto it = tinted.find(key);
+  if (it != tinted.end()) {
+    return it->second;
+  }
+
+  auto surface = Cairo::ImageSurface::create(
+      Cairo::FORMAT_ARGB32, atlas->get_width(), atlas->get_height());
+  auto cr = Cairo::Context::create(surface);
+  cr->set_source_rgb(r, g, b);
+  cr->mask(atlas, 0, 0);
+  tinted[key] = surface;
+  return surface;
+}
+
+void BitmapFont::draw_text(const Cairo::RefPtr<Cairo::Context> &cr, double x,
+                           double y, const std::string &text, double r,
+                           double g, double b) {
+  auto source = get_tinted_atlas(r, g, b);
+  auto fallback = glyph_index.find('?');
+
+  int column = 0;
+  for (gunichar c : Glib::ustring(text)) {
+    if (c != ' ') {
+      auto it = glyph_index.find(c);
+      if (it == glyph_index.end()) {
+        it = fallback;
+      }
+      double glyph_x = x + column * cell_width;
+      cr->set_source(source, glyph_x - it->second * cell_width, y);
+      cr->rectangle(glyph_x, y, cell_width, cell_height);
+      cr->fill();
+    }
+    column++;
+  }
+}
+
+BitmapFont &WillyGame::get_font(const std::string &family, int point_size) {
+  std::string key = family + ":" + std::to_string(point_size);
+  auto it = font_cache.find(key);
+  if (it == font_cache.end()) {
+    it = font_cache
+             .emplace(key, std::make_unique<BitmapFont>(family, point_size))
+             .first;
+  }
+  return *it->second;
+}
@@ -0,0 +1,220 @@
+#include "willy.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+FrameCapture::FrameCapture(const std::string &image_dir, int image_every,
+                           const std::string &image_format,
+                           const std::string &video_path, int video_fps,
+                           int buffers)
+    : image_dir(image_dir), image_every(std::max(1, image_every)),
+      image_format(image_format), video_path(video_path),
+      video_fps(std::max(1, video_fps)) {
+  frames.resize(std::max(1, buffers));
+  for (size_t i = 0; i < frames.size(); i++) {
+    free_frames.push_back(i);
+  }
+}
+
+FrameCapture::~FrameCapture() { finish(); }
+
+bool FrameCapture::start() {
+  if (!image_dir.empty()) {
+    std::error_code error;
+    std::filesystem::create_directories(image_dir, error);
+    if (error) {
+      std::cout << "Error: Cannot create capture directory " << image_dir
+                << ": " << error.message() << std::endl;
+      return false;
+    }
+    std::cout << "Capturing every " << image_every << " frame(s) to "
+              << image_dir << " as " << image_format << std::endl;
+  }
+
+  if (!video_path.empty()) {
+    video.open(video_path, std::ios::binary);
+    if (!video) {
+      std::cout << "Error: Cannot open " << video_path << " for writing"
+                << std::endl;
+      return false;
+    }
+    std::cout << "Exporting video to " << video_path << " at " << video_fps
+              << " fps" << std::endl;
+  }
+
+  writer = std::thread(&FrameCapture::writer_loop, this);
+  return true;
+}
+
+bool FrameCapture::wants_frame(int frame_number) const {
+  return video.is_open() ||
+         (!image_dir.empty() && frame_number % image_every == 0);
+}
+
+void FrameCapture::submit(const uint8_t *pixels, int width, int height,
+                          int stride, int frame_number, bool wait) {
+  int index;
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    if (wait) {
+      queue_changed.wait(lock, [this]() { return !free_frames.empty(); });
+    } else if (free_frames.empty()) {
+      // The writer is behind; losing a frame beats stalling the game
+      dropped++;
+      return;
+    }
+    index = free_frames.front();
+    free_frames.pop_front();
+  }
+
+  // The copy happens outside the lock; the buffer belongs to us until queued
+  Frame &frame = frames[index];
+  frame.width = width;
+  frame.height = height;
+  frame.stride = width * 4;
+  frame.number = frame_number;
+  frame.pixels.resize(static_cast<size_t>(frame.stride) * height);
+  for (int y = 0; y < height; y++) {
+    memcpy(&frame.pixels[static_cast<size_t>(y) * frame.stride],
+           pixels + static_cast<size_t>(y) * stride, frame.stride);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    pending_frames.push_back(index);
+  }
+  queue_changed.notify_all();
+}
+
+void FrameCapture::finish() {
+  if (!writer.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    stopping = true;
+  }
+  queue_changed.notify_all();
+  writer.join();
+
+  if (video.is_open()) {
+    video.close();
+  }
+  if (dropped > 0) {
+    std::cout << "Capture dropped " << dropped
+              << " frame(s) because the writer fell behind" << std::endl;
+  }
+  if (video_mismatches > 0) {
+    std::cout << "Video skipped " << video_mismatches
+              << " frame(s) whose size changed mid-stream" << std::endl;
+  }
+}
+
+void FrameCapture::writer_loop() {
+  while (true) {
+    int index;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex);
+      queue_changed.wait(
+          lock, [this]() { return stopping || !pending_frames.empty(); });
+      if (pending_frames.empty()) {
+        return; // stopping and drained
+      }
+      index = pending_frames.front();
+      pending_frames.pop_front();
+    }
+
+    const Frame &frame = frames[index];
+    if (!image_dir.empty() && frame.number % image_every == 0) {
+      write_image(frame);
+    }
+    if (video.is_open()) {
+      write_video_frame(frame);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex);
+      free_frames.push_back(index);
+    }
+    queue_changed.notify_all();
+  }
+}
+
+void FrameCapture::write_image(const Frame &frame) {
+  char name[32];
+  snprintf(name, sizeof(name), "frame_%06d.%s", frame.number,
+           image_format.c_str());
+  std::string path = image_dir + "/" + name;
+
+  if (image_format == "ppm") {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+      std::cout << "Error: Cannot write " << path << std::endl;
+      return;
+    }
+    file << "P6\n" << frame.width << " " << frame.height << "\n255\n";
+
+    std::vector<uint8_t> rgb(static_cast<size_t>(frame.width) * 3);
+    for (int y = 0; y < frame.height; y++) {
+      const uint32_t *src = reinterpret_cast<const uint32_t *>(
+          &frame.pixels[static_cast<size_t>(y) * frame.stride]);
+      for (int x = 0; x < frame.width; x++) {
+        rgb[x * 3 + 0] = (src[x] >> 16) & 0xFF;
+        rgb[x * 3 + 1] = (src[x] >> 8) & 0xFF;
+        rgb[x * 3 + 2] = src[x] & 0xFF;
+      }
+      file.write(reinterpret_cast<const char *>(rgb.data()), rgb.size());
+    }
+  } else {
+    // Wrap the buffer without copying; Cairo is fine with this off the GTK
+    // thread since the surface is private to the writer
+    auto surface = Cairo::ImageSurface::create(
+        const_cast<unsigned char *>(frame.pixels.data()), Cairo::FORMAT_ARGB32,
+        frame.width, frame.height, frame.stride);
+    try {
+      surface->write_to_png(path);
+    } catch (const std::exception &e) {
+      std::cout << "Error: Cannot write " << path << ": " << e.what()
+                << std::endl;
+    }
+  }
+}
+
+// YUV4MPEG2, 4:4:4 so no chroma is lost on the pixel art, BT.601 limited
+// range as players expect
+void FrameCapture::write_video_frame(const Frame &frame) {
+  if (video_width == 0) {
+    video_width = frame.width;
+    video_height = frame.height;
+    video << "YUV4MPEG2 W" << video_width << " H" << video_height << " F"
+          << video_fps << ":1 Ip A1:1 C444\n";
+  }
+  if (frame.width != video_width || frame.height != video_height) {
+    video_mismatches++;
+    return;
+  }
+
+  size_t plane = static_cast<size_t>(video_width) * video_height;
+  yuv.resize(plane * 3);
+  uint8_t *y_plane = yuv.data();
+  uint8_t *u_plane = y_plane + plane;
+  uint8_t *v_plane = u_plane + plane;
+
+  for (int y = 0; y < video_height; y++) {
+    const uint32_t *src = reinterpret_cast<const uint32_t *>(
+        &frame.pixels[static_cast<size_t>(y) * frame.stride]);
+    size_t row = static_cast<size_t>(y) * video_width;
+    for (int x = 0; x < video_width; x++) {
+      int r = (src[x] >> 16) & 0xFF;
+      int g = (src[x] >> 8) & 0xFF;
+      int b = src[x] & 0xFF;
+      y_plane[row + x] = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+      u_plane[row + x] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+      v_plane[row + x] = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+    }
+  }
+
+  video << "FRAME\n";
+  video.write(reinterpret_cast<const char *>(yuv.data()), yuv.size());
+}
@@ -5,15 +5,12 @@ extern double greenbg;
 extern double bluebg;
 
 void WillyGame::draw_intro_screen(const Cairo::RefPtr<Cairo::Context> &cr) {
-  // Get menubar height to use as offset
-  Gtk::Requisition menubar_min, menubar_nat;
-  menubar.get_preferred_size(menubar_min, menubar_nat);
-  int menubar_height = menubar_min.height;
+  int menubar_height = viewport.menubar_height;
 
   // Get current drawing area size
-  Gtk::Allocation allocation = drawing_area.get_allocation();
-  int area_width = allocation.get_width();
-  int area_height = allocation.get_height() - menubar_height;
+  int area_width, area_height;
+  get_render_size(area_width, area_height);
+  area_height -= menubar_height;
 
   // Apply offset for menubar and clear background
   cr->save();
@@ -65,12 +62,7 @@ void WillyGame::draw_intro_screen(const Cairo::RefPtr<Cairo::Context> &cr) {
   int base_font_size = std::max(10, std::min(20, line_height - 2));
 
   // Set up font
-  Pango::FontDescription font_desc;
-  font_desc.set_family("Courier");
-  font_desc.set_size(base_font_size * PANGO_SCALE);
-
-  auto layout = Pango::Layout::create(cr);
-  layout->set_font_description(font_desc);
+  BitmapFont &font = get_font("Courier", base_font_size);
 
   // Sprite size should match text height
   int sprite_size = base_font_size;
@@ -96,10 +88,7 @@ void WillyGame::draw_intro_screen(const Cairo::RefPtr<Cairo::Context> &cr) {
           element == "BELL" || element == "TACK" || element == "BALL") {
         line_width += sprite_size;
       } else {
-        layout->set_text(element);
-        int text_w, text_h;
-        layout->get_pixel_size(text_w, text_h);
-        line_width += text_w;
+        line_width += font.measure(element);
       }
     }
 
@@ -134,15 +123,8 @@ void WillyGame::draw_intro_screen(const Cairo::RefPtr<Cairo::Context> &cr) {
         current_x += sprite_size;
       } else {
         // Draw text
-        layout->set_text(element);
-        int text_w, text_h;
-        layout->get_pixel_size(text_w, text_h);
-
-        cr->set_source_rgb(1.0, 1.0, 1.0);
-        cr->move_to(current_x, y_pos);
-        layout->show_in_cairo_context(cr);
-
-        current_x += text_w;
+        font.draw_text(cr, current_x, y_pos, element, 1.0, 1.0, 1.0);
+        current_x += font.measure(element);
       }
     }
   }
@@ -151,52 +133,54 @@ void WillyGame::draw_intro_screen(const Cairo::RefPtr<Cairo::Context> &cr) {
 }
 
 void WillyGame::draw_game_over_screen(const Cairo::RefPtr<Cairo::Context> &cr) {
-  // Create font
-  Pango::FontDescription font_desc;
-  font_desc.set_family("Monospace");
-  font_desc.set_size(24 * PANGO_SCALE);
-
-  auto layout = create_pango_layout("");
-  layout->set_font_description(font_desc);
-
-  cr->set_source_rgb(1.0, 1.0, 1.0); // White text
+  BitmapFont &font = get_font("Monospace", 24);
+  int screen_width = GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor;
 
   // Game Over text
-  layout->set_text("GAME OVER");
-  int text_width, text_height;
-  layout->get_pixel_size(text_width, text_height);
-
-  int x_offset =
-      (GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor - text_width) / 2;
-  int y_offset =
-      (GAME_SCREEN_HEIGHT * GAME_CHAR_HEIGHT * scale_factor - text_height) / 2 -
-      50;
-
-  cr->move_to(x_offset, y_offset);
-  layout->show_in_cairo_context(cr);
+  std::string game_over_text = "GAME OVER";
+  int x_offset = (screen_width - font.measure(game_over_text)) / 2;
+  int y_offset = (GAME_SCREEN_HEIGHT * GAME_CHAR_HEIGHT * scale_factor -
+                  font.get_cell_height()) /
+                     2 -
+                 50;
+  font.draw_text(cr, x_offset, y_offset, game_over_text, 1.0, 1.0, 1.0);
 
   // Final Score
-  std::string score_text = "Final Score: " + std::to_string(score);
-  layout->set_text(score_text);
-  layout->get_pixel_size(text_width, text_height);
-
-  x_offset =
-      (GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor - text_width) / 2;
+  std::string score_text = "Final Score: " + std::to_string(view->score);
+  x_offset = (screen_width - font.measure(score_text)) / 2;
   y_offset += 60;
-
-  cr->move_to(x_offset, y_offset);
-  layout->show_in_cairo_context(cr);
+  font.draw_text(cr, x_offset, y_offset, score_text, 1.0, 1.0, 1.0);
 
   // Continue text
-  layout->set_text("Press Enter to return to intro");
-  layout->get_pixel_size(text_width, text_height);
-
-  x_offset =
-      (GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor - text_width) / 2;
+  std::string continue_text = "Press Enter to return to intro";
+  x_offset = (screen_width - font.measure(continue_text)) / 2;
   y_offset += 80;
+  font.draw_text(cr, x_offset, y_offset, continue_text, 1.0, 1.0, 1.0);
+}
+
+void WillyGame::draw_paused_overlay(const Cairo::RefPtr<Cairo::Context> &cr) {
+  BitmapFont &font = get_font("Monospace", 24);
+  int screen_width = GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor;
+  int screen_height = GAME_SCREEN_HEIGHT * GAME_CHAR_HEIGHT * scale_factor;
+
+  cr->save();
+  viewport.apply(cr);
 
-  cr->move_to(x_offset, y_offset);
-  layout->show_in_cairo_context(cr);
+  // Dim the frozen game underneath
+  cr->set_source_rgba(0.0, 0.0, 0.0, 0.5);
+  cr->rectangle(0, 0, screen_width, screen_height);
+  cr->fill();
+
+  std::string paused_text = "PAUSED";
+  int y_offset = (screen_height - font.get_cell_height()) / 2 - 30;
+  font.draw_text(cr, (screen_width - font.measure(paused_text)) / 2, y_offset,
+                 paused_text, 1.0, 1.0, 1.0);
+
+  std::string continue_text = "Press any key to continue";
+  y_offset += 60;
+  font.draw_text(cr, (screen_width - font.measure(continue_text)) / 2,
+                 y_offset, continue_text, 1.0, 1.0, 1.0);
+  cr->restore();
 }
 
 // WillyApplication implementation
@@ -207,114 +191,106 @@ Glib::RefPtr<WillyApplication> WillyApplication::create() {
   return Glib::RefPtr<WillyApplication>(new WillyApplication());
 }
 
+// The death flash is a timed overlay rather than a blocking loop: it lasts a
+// quarter of a second worth of ticks and render_frame paints it over
+// whatever screen is current
 void WillyGame::flash_death_screen() {
-  // Get the window and context for drawing
-  auto window = drawing_area.get_window();
-  if (!window)
-    return;
+  flash_ticks_left = std::max(1, (int)std::lround(0.25 * fps));
+  flash_strobe = false;
+}
 
-  auto cr = window->create_cairo_context();
+void WillyGame::flash_death_screen_seizure() {
+  // Same duration, alternating white and the background colour every frame
+  flash_ticks_left = std::max(1, (int)std::lround(0.25 * fps));
+  flash_strobe = true;
+}
 
-  // Flash white for 0.25 seconds
-  cr->set_source_rgb(1.0, 1.0, 1.0); // White
+void WillyGame::draw_death_flash(const Cairo::RefPtr<Cairo::Context> &cr) {
+  if (view->flash_strobe && view->flash_ticks_left % 2 == 0) {
+    cr->set_source_rgb(redbg, greenbg, bluebg);
+  } else {
+    cr->set_source_rgb(1.0, 1.0, 1.0); // White
+  }
   cr->paint();
+}
 
-  // Force immediate display update
-  window->invalidate(false);
-
-  // Process pending GTK events to ensure the white screen shows
-  while (Gtk::Main::events_pending()) {
-    Gtk::Main::iteration();
+void WillyGame::draw_cached_screen(const Cairo::RefPtr<Cairo::Context> &cr,
+                                   ScreenCache &cache, const std::string &key,
+                                   const FrameDrawer &draw) {
+  if (!cache.surface || cache.key != key) {
+    int width, height;
+    get_render_size(width, height);
+    cache.surface = Cairo::ImageSurface::create(
+        Cairo::FORMAT_ARGB32, std::max(1, width), std::max(1, height));
+    draw(Cairo::Context::create(cache.surface));
+    cache.key = key;
   }
 
-  // Hold the white screen for 0.25 seconds
-  std::this_thread::sleep_for(std::chrono::milliseconds(250));
-
-  // Return to normal - this will be handled by the next game tick/draw cycle
+  cr->set_source(cache.surface, 0, 0);
+  cr->paint();
 }
 
-void WillyGame::flash_death_screen_seizure() {
-  // Get the current drawing area allocation
-  Gtk::Allocation allocation = drawing_area.get_allocation();
-
-  // Calculate the duration of the flashing in seconds (0.25 seconds like
-  // Python)
-  double duration = 0.25;
-
-  // Calculate the number of times to switch between colors (assuming ~60 FPS)
-  int num_flashes = static_cast<int>(duration * 60);
-
-  // Colors to alternate between
-  Cairo::RefPtr<Cairo::ImageSurface> surface1 = Cairo::ImageSurface::create(
-      Cairo::FORMAT_RGB24, allocation.get_width(), allocation.get_height());
-  Cairo::RefPtr<Cairo::ImageSurface> surface2 = Cairo::ImageSurface::create(
-      Cairo::FORMAT_RGB24, allocation.get_width(), allocation.get_height());
-
-  // Fill surfaces with different colors
-  auto ctx1 = Cairo::Context::create(surface1);
-  ctx1->set_source_rgb(1.0, 1.0, 1.0); // White
-  ctx1->paint();
-
-  auto ctx2 = Cairo::Context::create(surface2);
-  ctx2->set_source_rgb(redbg, greenbg,
-                       bluebg); // Blue (or current background color)
-  ctx2->paint();
-
-  // Get the window and context for drawing
-  auto window = drawing_area.get_window();
-  if (!window)
-    return;
-
-  auto cr = window->create_cairo_context();
-
-  // Start the flashing
-  for (int i = 0; i < num_flashes; i++) {
-    // Alternate between the two colors
-    if (i % 2 == 0) {
-      cr->set_source(surface1, 0, 0);
-    } else {
-      cr->set_source(surface2, 0, 0);
-    }
-
-    cr->paint();
+void WillyGame::get_render_size(int &width, int &height) {
+  if (drawing_capture) {
+    capture_target->get_size(width, height);
+  } else if (renderer) {
+    renderer->get_size(width, height);
+  } else {
+    Gtk::Allocation allocation = game_window->drawing_area.get_allocation();
+    width = allocation.get_width();
+    height = allocation.get_height();
+  }
+}
 
-    // Force immediate display update
-    window->invalidate(false);
+bool WillyGame::on_draw(const Cairo::RefPtr<Cairo::Context> &cr) {
+  render_frame(cr);
+  return true;
+}
 
-    // Process pending GTK events
-    while (Gtk::Main::events_pending()) {
-      Gtk::Main::iteration();
-    }
+void WillyGame::render_frame(const Cairo::RefPtr<Cairo::Context> &cr) {
+  int width, height;
+  get_render_size(width, height);
+  char size_key[32];
+  snprintf(size_key, sizeof(size_key), "%dx%d+%d:", width, height,
+           viewport.menubar_height);
 
-    // Wait for a short amount of time before the next frame
-    std::this_thread::sleep_for(
-        std::chrono::microseconds(static_cast<int>(1000000.0 / 60.0)));
+  if (loading) {
+    draw_splash_screen(cr);
+    return;
   }
 
-  // Clear back to normal background
-  cr->set_source_rgb(redbg, greenbg, bluebg); // Blue
-  cr->paint();
-  window->invalidate(false);
-}
-
-bool WillyGame::on_draw(const Cairo::RefPtr<Cairo::Context> &cr) {
   // Only paint blue background for intro screen
-  if (current_state == GameState::INTRO) {
-    cr->set_source_rgb(redbg, greenbg,
-                       bluebg); // Blue background for intro only
-    cr->paint();
-    draw_intro_screen(cr);
-  } else if (current_state == GameState::PLAYING) {
+  if (view->state == GameState::INTRO) {
+    draw_cached_screen(
+        cr, intro_cache,
+        size_key + std::to_string(argb_from_rgb(redbg, greenbg, bluebg)),
+        [this](const Cairo::RefPtr<Cairo::Context> &cache_cr) {
+          cache_cr->set_source_rgb(redbg, greenbg,
+                                   bluebg); // Blue background for intro only
+          cache_cr->paint();
+          draw_intro_screen(cache_cr);
+        });
+  } else if (view->state == GameState::PLAYING) {
     draw_game_screen(cr);
-  } else if (current_state == GameState::GAME_OVER) {
+  } else if (view->state == GameState::PAUSED) {
+    draw_game_screen(cr);
+    draw_paused_overlay(cr);
+  } else if (view->state == GameState::GAME_OVER) {
     draw_game_over_screen(cr);
-  } else if (current_state == GameState::HIGH_SCORE_ENTRY) {
+  } else if (view->state == GameState::HIGH_SCORE_ENTRY) {
     draw_high_score_entry_screen(cr);
-  } else if (current_state == GameState::HIGH_SCORE_DISPLAY) {
-    draw_high_score_display_screen(cr);
+  } else if (view->state == GameState::HIGH_SCORE_DISPLAY) {
+    draw_cached_screen(
+        cr, high_score_cache,
+        size_key + std::to_string(score_manager->get_version()),
+        [this](const Cairo::RefPtr<Cairo::Context> &cache_cr) {
+          draw_high_score_display_screen(cache_cr);
+        });
   }
 
-  return true;
+  if (view->flash_ticks_left > 0) {
+    draw_death_flash(cr);
+  }
 }
 
 std::pair<int, int> WillyGame::find_ballpit_position() {
@@ -330,87 +306,98 @@ std::pair<int, int> WillyGame::find_ballpit_position() {
 }
 
 void WillyGame::draw_game_screen(const Cairo::RefPtr<Cairo::Context> &cr) {
-  // Get menubar height to use as offset
-  Gtk::Requisition menubar_min, menubar_nat;
-  menubar.get_preferred_size(menubar_min, menubar_nat);
-  int menubar_height = menubar_min.height;
-
   // Apply scaling transformation
   cr->save();
-  cr->translate(0, menubar_height);
-  cr->scale(current_scale_x, current_scale_y);
-
-  // Calculate the scaled character dimensions
-  int scaled_char_width = GAME_CHAR_WIDTH * scale_factor;
-  int scaled_char_height = GAME_CHAR_HEIGHT * scale_factor;
-
-  // Draw ALL sprite positions with blue background, even empty ones
-  for (int row = 0; row < GAME_MAX_HEIGHT; row++) {
-    for (int col = 0; col < GAME_MAX_WIDTH; col++) {
-      int x = col * scaled_char_width;
-      int y = row * scaled_char_height;
-
-      // Paint blue background for EVERY sprite position
-      cr->set_source_rgb(redbg, greenbg, bluebg);
-      cr->rectangle(x, y, scaled_char_width, scaled_char_height);
-      cr->fill();
-
-      // Get the tile at this position
-      std::string tile = get_tile(row, col);
-
-      // Draw sprite if not empty or Willy start position, but not at Willy's
-      // current position
-      if (tile != "EMPTY" && tile.find("WILLY") == std::string::npos &&
-          !(row == willy_position.first && col == willy_position.second)) {
-        auto sprite = sprite_loader->get_sprite(tile);
-        if (sprite) {
-          cr->set_source(sprite, x, y);
-          cr->paint();
+  viewport.apply(cr);
+
+  // Character cells in game pixels
+  int scaled_char_width = viewport.cell_width;
+  int scaled_char_height = viewport.cell_height;
+
+  if (sprite_loader->has_masks()) {
+    // Compose the whole screen at native resolution as palette indices, then
+    // scale it to the window and blit it in one go
+    compose_game_frame();
+    paint_indexed_framebuffer(cr, framebuffer, frame_surface,
+                              (double)scaled_char_width /
+                                  sprite_loader->get_mask_size());
+  } else {
+    const std::pair<int, int> &willy = view->willy_position;
+
+    // Draw ALL sprite positions with blue background, even empty ones
+    for (int row = 0; row < GAME_MAX_HEIGHT; row++) {
+      for (int col = 0; col < GAME_MAX_WIDTH; col++) {
+        int x = col * scaled_char_width;
+        int y = row * scaled_char_height;
+
+        // Paint blue background for EVERY sprite position
+        cr->set_source_rgb(redbg, greenbg, bluebg);
+        cr->rectangle(x, y, scaled_char_width, scaled_char_height);
+        cr->fill();
+
+        // Get the tile at this position
+        std::string tile = view->tile(row, col);
+
+        // Draw sprite if not empty or Willy start position, but not at
+        // Willy's current position
+        if (tile != "EMPTY" && tile.find("WILLY") == std::string::npos &&
+            !(row == willy.first && col == willy.second)) {
+          auto sprite = sprite_loader->get_sprite(tile);
+          if (sprite) {
+            cr->set_source(sprite, x, y);
+            cr->paint();
+          }
         }
       }
     }
-  }
-
-  // Draw balls (but not the ones in ball pits or at Willy's position)
-  for (const auto &ball : balls) {
-    if (get_tile(ball.row, ball.col) != "BALLPIT" &&
-        !(ball.row == willy_position.first &&
-          ball.col == willy_position.second)) {
-
-      // Make sure ball is in visible area
-      if (ball.row >= 0 && ball.row < GAME_MAX_HEIGHT && ball.col >= 0 &&
-          ball.col < GAME_MAX_WIDTH) {
-
-        int x = ball.col * scaled_char_width;
-        int y = ball.row * scaled_char_height;
 
-        auto sprite = sprite_loader->get_sprite("BALL");
-        if (sprite) {
-          cr->set_source(sprite, x, y);
-          cr->paint();
+    // Draw balls (but not the ones in ball pits or at Willy's position)
+    for (const auto &ball : view->balls) {
+      if (view->tile(ball.row, ball.col) != "BALLPIT" &&
+          !(ball.row == willy.first && ball.col == willy.second)) {
+
+        // Make sure ball is in visible area
+        if (ball.row >= 0 && ball.row < GAME_MAX_HEIGHT && ball.col >= 0 &&
+            ball.col < GAME_MAX_WIDTH) {
+
+          double x =
+              interpolate_cell(ball.prev_col, ball.col) * scaled_char_width;
+          double y =
+              interpolate_cell(ball.prev_row, ball.row) * scaled_char_height;
+
+          auto sprite = sprite_loader->get_sprite("BALL");
+          if (sprite) {
+            cr->set_source(sprite, x, y);
+            cr->paint();
+          }
         }
       }
     }
-  }
-
-  // Draw Willy - make sure he's in visible area
-  if (willy_position.first >= 0 && willy_position.first < GAME_MAX_HEIGHT &&
-      willy_position.second >= 0 && willy_position.second < GAME_MAX_WIDTH) {
 
-    int x = willy_position.second * scaled_char_width;
-    int y = willy_position.first * scaled_char_height;
-
-    std::string sprite_name =
-        (willy_direction == "LEFT") ? "WILLY_LEFT" : "WILLY_RIGHT";
-    auto sprite = sprite_loader->get_sprite(sprite_name);
-    if (sprite) {
-      cr->set_source(sprite, x, y);
-      cr->paint();
+    // Draw Willy - make sure he's in visible area
+    if (willy.first >= 0 && willy.first < GAME_MAX_HEIGHT &&
+        willy.second >= 0 && willy.second < GAME_MAX_WIDTH) {
+
+      double x =
+          interpolate_cell(view->willy_interp_from.second, willy.second) *
+          scaled_char_width;
+      double y = interpolate_cell(view->willy_interp_from.first, willy.first) *
+                 scaled_char_height;
+
+      std::string sprite_name =
+          (view->willy_direction == "LEFT") ? "WILLY_LEFT" : "WILLY_RIGHT";
+      auto sprite = sprite_loader->get_sprite(sprite_name);
+      if (sprite) {
+        cr->set_source(sprite, x, y);
+        cr->paint();
+      }
     }
   }
 
-  // Draw status information below the game area
-  if (current_state == GameState::PLAYING) {
+  // Draw status information below the game area; a pause only dims the
+  // playfield above it
+  if (view->state == GameState::PLAYING ||
+      view->state == GameState::PAUSED) {
     // Calculate status bar area (below the main game area)
     int status_y = (GAME_SCREEN_HEIGHT + 1) *
                    scaled_char_height;          // +1 to go BELOW the last line
@@ -422,57 +409,163 @@ void WillyGame::draw_game_screen(const Cairo::RefPtr<Cairo::Context> &cr) {
                   status_height);
     cr->fill();
 
-    // Create font for status text
-    Pango::FontDescription font_desc;
-    font_desc.set_family("Courier");
-    // Scale font size based on the current scale - make it bigger and scale
-    // properly
-    int font_size =
-        std::max(12, (int)(16 * std::min(current_scale_x, current_scale_y)));
+    // Font size follows the scale, but the glyphs are drawn unscaled so they
+    // stay sharp
+    int font_size = std::max(12, (int)(16 * viewport.scale));
     if (font_size > 16) {
       font_size = 16;
     }
-    font_desc.set_size(font_size * PANGO_SCALE);
+    BitmapFont &font = get_font(
+        "Courier", std::max(1, (int)std::lround(font_size * viewport.scale)));
 
-    auto layout = Pango::Layout::create(cr);
-    layout->set_font_description(font_desc);
     // Create status text with fixed-width formatting
     char status_buffer[200];
     snprintf(
         status_buffer, sizeof(status_buffer),
         "SCORE: %5d    BONUS: %4d    LEVEL: %2d    WILLY THE WORMS LEFT: %3d",
-        score, bonus, level, lives);
+        view->score, view->bonus, view->level, view->lives);
     std::string status_text = status_buffer;
 
-    layout->set_text(status_text);
+    // Center the text in the status area, working in window pixels
+    double area_width = GAME_SCREEN_WIDTH * scaled_char_width * viewport.scale;
+    double text_x = (area_width - font.measure(status_text)) / 2;
+    double text_y = (status_y + status_height / 2.0) * viewport.scale -
+                    font.get_cell_height() / 2.0;
+
+    cr->save();
+    cr->scale(1.0 / viewport.scale, 1.0 / viewport.scale);
+    font.draw_text(cr, std::round(text_x), std::round(text_y), status_text,
+                   1.0, 1.0, 1.0);
+    cr->restore();
+  }
 
-    // Draw white text
-    cr->set_source_rgb(1.0, 1.0, 1.0);
+  cr->restore();
+}
 
-    // Position text in the status area
-    int text_width, text_height;
-    layout->get_pixel_size(text_width, text_height);
+void paint_indexed_framebuffer(const Cairo::RefPtr<Cairo::Context> &cr,
+                               const IndexedFramebuffer &fb,
+                               Cairo::RefPtr<Cairo::ImageSurface> &surface,
+                               double scale) {
+  // Work out how big one framebuffer pixel ends up on screen
+  Cairo::Matrix matrix;
+  cr->get_matrix(matrix);
+  double device_x = scale * matrix.xx;
+  double device_y = scale * matrix.yy;
+
+  // Scale up by the whole part in software. If that is the full scale the
+  // surface is painted 1:1, otherwise the small remainder is left to a
+  // bilinear paint (sharp bilinear), which only softens pixel edges.
+  int factor =
+      std::max(1, (int)std::floor(std::min(device_x, device_y) + 1e-6));
+  bool exact = std::fabs(device_x - factor) < 1e-6 &&
+               std::fabs(device_y - factor) < 1e-6;
+
+  int width = fb.get_width() * factor;
+  int height = fb.get_height() * factor;
+  if (!surface || surface->get_width() != width ||
+      surface->get_height() != height) {
+    surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
+  }
 
-    // Center the text in the status area
-    int text_x = (GAME_SCREEN_WIDTH * scaled_char_width - text_width) / 2;
-    int text_y = status_y + (status_height - text_height) / 2;
+  surface->flush();
+  fb.expand_scaled(reinterpret_cast<uint32_t *>(surface->get_data()),
+                   surface->get_stride(), factor);
+  surface->mark_dirty();
 
-    cr->move_to(text_x, text_y);
-    layout->show_in_cairo_context(cr);
+  cr->save();
+  cr->set_identity_matrix();
+  cr->translate(std::round(matrix.x0), std::round(matrix.y0));
+  cr->scale(device_x / factor, device_y / factor);
+  auto pattern = Cairo::SurfacePattern::create(surface);
+  pattern->set_filter(exact ? Cairo::FILTER_NEAREST : Cairo::FILTER_BILINEAR);
+  cr->set_source(pattern);
+  cr->paint();
+  cr->restore();
+}
+
+void WillyGame::compose_game_frame() {
+  int cell = sprite_loader->get_mask_size();
+  int width = GAME_MAX_WIDTH * cell;
+  int height = GAME_MAX_HEIGHT * cell;
+  if (framebuffer.get_width() != width || framebuffer.get_height() != height) {
+    framebuffer.resize(width, height);
   }
 
-  cr->restore();
+  // The background colour is just palette slot 0
+  framebuffer.set_palette(PALETTE_BACKGROUND,
+                          argb_from_rgb(redbg, greenbg, bluebg));
+  framebuffer.clear(PALETTE_BACKGROUND);
+
+  const std::pair<int, int> &willy = view->willy_position;
+
+  for (int row = 0; row < GAME_MAX_HEIGHT; row++) {
+    for (int col = 0; col < GAME_MAX_WIDTH; col++) {
+      if (row == willy.first && col == willy.second) {
+        continue;
+      }
+      std::string tile = view->tile(row, col);
+      if (tile == "EMPTY" || tile.find("WILLY") != std::string::npos) {
+        continue;
+      }
+      const uint32_t *mask = sprite_loader->get_mask(tile);
+      if (mask) {
+        framebuffer.draw_glyph(col * cell, row * cell, mask, cell,
+                               PALETTE_TILE);
+      }
+    }
+  }
+
+  const uint32_t *ball_mask = sprite_loader->get_mask("BALL");
+  for (const auto &ball : view->balls) {
+    if (ball_mask && ball.row >= 0 && ball.row < GAME_MAX_HEIGHT &&
+        ball.col >= 0 && ball.col < GAME_MAX_WIDTH &&
+        view->tile(ball.row, ball.col) != "BALLPIT" &&
+        !(ball.row == willy.first && ball.col == willy.second)) {
+      framebuffer.draw_glyph(
+          (int)std::lround(interpolate_cell(ball.prev_col, ball.col) * cell),
+          (int)std::lround(interpolate_cell(ball.prev_row, ball.row) * cell),
+          ball_mask, cell, PALETTE_BALL);
+    }
+  }
+
+  if (willy.first >= 0 && willy.first < GAME_MAX_HEIGHT && willy.second >= 0 &&
+      willy.second < GAME_MAX_WIDTH) {
+    const uint32_t *mask = sprite_loader->get_mask(
+        (view->willy_direction == "LEFT") ? "WILLY_LEFT" : "WILLY_RIGHT");
+    if (mask) {
+      const std::pair<int, int> &from = view->willy_interp_from;
+      double col = interpolate_cell(from.second, willy.second);
+      double row = interpolate_cell(from.first, willy.first);
+      framebuffer.draw_glyph((int)std::lround(col * cell),
+                             (int)std::lround(row * cell), mask, cell,
+                             PALETTE_WILLY);
+    }
+  }
+}
+
+// Where a sprite that moved between cells this step is drawn. Anything that
+// jumped further than a neighbouring cell (a death, a ball pit) snaps.
+double WillyGame::interpolate_cell(int from, int to) const {
+  if (std::abs(to - from) > 1) {
+    return to;
+  }
+  return from + (to - from) * frame_interpolation;
 }
 
 void WillyGame::update_status_bar() {
-  if (current_state == GameState::PLAYING) {
-    std::string status_text =
-        "SCORE: " + std::to_string(score) +
-        "    BONUS: " + std::to_string(bonus) +
-        "    Level: " + std::to_string(level) +
-        "    Willy the Worms Left: " + std::to_string(lives);
+  if (!game_window) {
+    return; // Headless runs have no status bar
+  }
+  std::string status_text = "Willy the Worm - C++ GTK Edition";
+  if (view->state == GameState::PLAYING) {
+    status_text = "SCORE: " + std::to_string(view->score) +
+                  "    BONUS: " + std::to_string(view->bonus) +
+                  "    Level: " + std::to_string(view->level) +
+                  "    Willy the Worms Left: " + std::to_string(view->lives);
+  }
+  // Setting the label, even to the same text, costs a relayout
+  Gtk::Label &status_bar = game_window->status_bar;
+  if (status_bar.get_text() != status_text) {
     status_bar.set_text(status_text);
-  } else {
-    status_bar.set_text("Willy the Worm - C++ GTK Edition");
   }
 }
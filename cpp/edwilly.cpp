@@ -60,6 +60,8 @@ private:
 
   std::unique_ptr<SpriteLoader> sprite_loader;
   std::unique_ptr<LevelLoader> level_loader;
+  IndexedFramebuffer framebuffer;
+  Cairo::RefPtr<Cairo::ImageSurface> frame_surface;
 
   // Editor state
   int scale_factor;
@@ -69,9 +71,8 @@ private:
 
   SpriteIterator sprite_iterator;
 
-  // Scaling factors for window resizing
-  double current_scale_x = 1.0;
-  double current_scale_y = 1.0;
+  // Game-to-window transform, redone when the size changes
+  Viewport viewport;
   int base_game_width;
   int base_game_height;
   void test_level();
@@ -94,7 +95,7 @@ private:
   void next_level();
   void change_background_color(int color_component);
   void update_status_bar();
-  void calculate_scaling_factors();
+  bool update_viewport();
   void on_window_resize();
   bool on_scroll_event(GdkEventScroll *event);
   std::pair<int, int> screen_to_grid(double screen_x, double screen_y);
@@ -155,7 +156,7 @@ WillyEditor::WillyEditor()
       sigc::hide(sigc::mem_fun(*this, &WillyEditor::on_window_resize)));
 
   // Initial scaling calculation
-  calculate_scaling_factors();
+  update_viewport();
 
   drawing_area.grab_focus();
 
@@ -299,7 +300,6 @@ bool WillyEditor::on_key_press(GdkEventKey *event) {
       redbg = 0.0;
       greenbg = 0.0;
       bluebg = 1.0;
-      sprite_loader = std::make_unique<SpriteLoader>(scale_factor);
     }
   }
 
@@ -387,26 +387,7 @@ bool WillyEditor::on_button_press(GdkEventButton *event) {
 
 std::pair<int, int> WillyEditor::screen_to_grid(double screen_x,
                                                 double screen_y) {
-  // Get menubar height to account for offset
-  Gtk::Requisition menubar_min, menubar_nat;
-  menubar.get_preferred_size(menubar_min, menubar_nat);
-  int menubar_height = menubar_min.height;
-
-  // Adjust for menubar offset
-  screen_y -= menubar_height;
-
-  // Account for scaling
-  screen_x /= current_scale_x;
-  screen_y /= current_scale_y;
-
-  // Convert to grid coordinates
-  int scaled_char_width = GAME_CHAR_WIDTH * scale_factor;
-  int scaled_char_height = GAME_CHAR_HEIGHT * scale_factor;
-
-  int col = (int)(screen_x / scaled_char_width);
-  int row = (int)(screen_y / scaled_char_height);
-
-  return {row, col};
+  return viewport.to_cell(screen_x, screen_y);
 }
 
 void WillyEditor::place_sprite(int row, int col,
@@ -540,9 +521,6 @@ void WillyEditor::change_background_color(int color_component) {
     *color_ptr = 0.25;
   }
 
-  // Recreate sprite loader with new background colors
-  sprite_loader = std::make_unique<SpriteLoader>(scale_factor);
-
   std::cout << color_name << " component set to: " << *color_ptr << std::endl;
 }
 
@@ -553,10 +531,24 @@ void WillyEditor::update_status_bar() {
   status_bar.set_text(status_text);
 }
 
-void WillyEditor::calculate_scaling_factors() {
+// Only recomputed when the window or drawing area really changed size.
+// Returns true if it changed.
+bool WillyEditor::update_viewport() {
   // Get current window size
   int window_width, window_height;
   get_size(window_width, window_height);
+  Gtk::Allocation allocation = drawing_area.get_allocation();
+
+  if (window_width == viewport.window_width &&
+      window_height == viewport.window_height &&
+      allocation.get_width() == viewport.target_width &&
+      allocation.get_height() == viewport.target_height) {
+    return false;
+  }
+  viewport.window_width = window_width;
+  viewport.window_height = window_height;
+  viewport.target_width = allocation.get_width();
+  viewport.target_height = allocation.get_height();
 
   // Get menubar and status bar heights
   Gtk::Requisition menubar_min, menubar_nat;
@@ -577,18 +569,22 @@ void WillyEditor::calculate_scaling_factors() {
   // Use the smaller scale to maintain aspect ratio
   double scale = std::min(scale_x, scale_y);
 
-  // Round to nearest 0.1
-  current_scale_x = std::round(scale * 10.0) / 10.0;
-  current_scale_y = current_scale_x; // Maintain aspect ratio
+  // Round to nearest 0.1, and don't scale below 0.1 or above 10.0
+  viewport.scale = std::round(scale * 10.0) / 10.0;
+  viewport.scale = std::max(0.1, std::min(10.0, viewport.scale));
 
-  // Don't scale below 0.1 or above 10.0
-  current_scale_x = std::max(0.1, std::min(10.0, current_scale_x));
-  current_scale_y = std::max(0.1, std::min(10.0, current_scale_y));
+  viewport.menubar_height = menubar_min.height;
+  viewport.origin_x = 0.0;
+  viewport.origin_y = menubar_min.height;
+  viewport.cell_width = GAME_CHAR_WIDTH * scale_factor;
+  viewport.cell_height = GAME_CHAR_HEIGHT * scale_factor;
+  return true;
 }
 
 void WillyEditor::on_window_resize() {
-  calculate_scaling_factors();
-  drawing_area.queue_draw();
+  if (update_viewport()) {
+    drawing_area.queue_draw();
+  }
 }
 
 bool WillyEditor::on_draw(const Cairo::RefPtr<Cairo::Context> &cr) {
@@ -605,10 +601,7 @@ bool WillyEditor::on_draw(const Cairo::RefPtr<Cairo::Context> &cr) {
 }
 
 void WillyEditor::draw_intro_screen(const Cairo::RefPtr<Cairo::Context> &cr) {
-  // Get menubar height to use as offset
-  Gtk::Requisition menubar_min, menubar_nat;
-  menubar.get_preferred_size(menubar_min, menubar_nat);
-  int menubar_height = menubar_min.height;
+  int menubar_height = viewport.menubar_height;
 
   // Get current drawing area size
   Gtk::Allocation allocation = drawing_area.get_allocation();
@@ -753,48 +746,69 @@ void WillyEditor::draw_intro_screen(const Cairo::RefPtr<Cairo::Context> &cr) {
 }
 
 void WillyEditor::draw_editor_screen(const Cairo::RefPtr<Cairo::Context> &cr) {
-  // Get menubar height to use as offset
-  Gtk::Requisition menubar_min, menubar_nat;
-  menubar.get_preferred_size(menubar_min, menubar_nat);
-  int menubar_height = menubar_min.height;
-
   // Apply scaling transformation
   cr->save();
-  cr->translate(0, menubar_height);
-  cr->scale(current_scale_x, current_scale_y);
-
-  // Calculate the scaled character dimensions
-  int scaled_char_width = GAME_CHAR_WIDTH * scale_factor;
-  int scaled_char_height = GAME_CHAR_HEIGHT * scale_factor;
-
-  // Draw background for game area (40 columns) plus preview column (column 40)
-  for (int row = 0; row < GAME_MAX_HEIGHT; row++) {
-    for (int col = 0; col <= 40; col++) { // Include column 40 for preview
-      int x = col * scaled_char_width;
-      int y = row * scaled_char_height;
-
-      // Paint background
-      cr->set_source_rgb(redbg, greenbg, bluebg);
-      cr->rectangle(x, y, scaled_char_width, scaled_char_height);
-      cr->fill();
-
-      // Get the tile at this position
-      std::string tile;
-      if (col < GAME_MAX_WIDTH) {
-        tile = level_loader->get_tile(current_level, row, col);
-      } else if (col == 40 && row == 0) {
-        // Preview sprite in column 40, row 0
-        tile = sprite_iterator.current();
-      } else {
-        tile = "EMPTY";
+  viewport.apply(cr);
+
+  // Character cells in game pixels
+  int scaled_char_width = viewport.cell_width;
+  int scaled_char_height = viewport.cell_height;
+
+  // Game area (40 columns) plus preview column (column 40)
+  const int columns = GAME_MAX_WIDTH + 1;
+  auto tile_at = [&](int row, int col) -> std::string {
+    if (col < GAME_MAX_WIDTH) {
+      return level_loader->get_tile(current_level, row, col);
+    } else if (col == 40 && row == 0) {
+      // Preview sprite in column 40, row 0
+      return sprite_iterator.current();
+    }
+    return "EMPTY";
+  };
+
+  if (sprite_loader->has_masks()) {
+    int cell = sprite_loader->get_mask_size();
+    if (framebuffer.get_width() != columns * cell ||
+        framebuffer.get_height() != GAME_MAX_HEIGHT * cell) {
+      framebuffer.resize(columns * cell, GAME_MAX_HEIGHT * cell);
+    }
+    framebuffer.set_palette(PALETTE_BACKGROUND,
+                            argb_from_rgb(redbg, greenbg, bluebg));
+    framebuffer.clear(PALETTE_BACKGROUND);
+
+    for (int row = 0; row < GAME_MAX_HEIGHT; row++) {
+      for (int col = 0; col < columns; col++) {
+        std::string tile = tile_at(row, col);
+        const uint32_t *mask =
+            (tile != "EMPTY") ? sprite_loader->get_mask(tile) : nullptr;
+        if (mask) {
+          framebuffer.draw_glyph(col * cell, row * cell, mask, cell,
+                                 PALETTE_TILE);
+        }
       }
+    }
 
-      // Draw sprite if not empty
-      if (tile != "EMPTY") {
-        auto sprite = sprite_loader->get_sprite(tile);
-        if (sprite) {
-          cr->set_source(sprite, x, y);
-          cr->paint();
+    paint_indexed_framebuffer(cr, framebuffer, frame_surface,
+                              (double)scaled_char_width / cell);
+  } else {
+    for (int row = 0; row < GAME_MAX_HEIGHT; row++) {
+      for (int col = 0; col < columns; col++) {
+        int x = col * scaled_char_width;
+        int y = row * scaled_char_height;
+
+        // Paint background
+        cr->set_source_rgb(redbg, greenbg, bluebg);
+        cr->rectangle(x, y, scaled_char_width, scaled_char_height);
+        cr->fill();
+
+        // Draw sprite if not empty
+        std::string tile = tile_at(row, col);
+        if (tile != "EMPTY") {
+          auto sprite = sprite_loader->get_sprite(tile);
+          if (sprite) {
+            cr->set_source(sprite, x, y);
+            cr->paint();
+          }
         }
       }
     }
@@ -969,14 +983,15 @@ int run_edwilly_game(const GameOptions &options) {
   std::cout << "\n";
   game_options.one_level=true;
   // Create the game window directly instead of a new application
-  auto game_window = std::make_unique<WillyGame>();
+  auto game = std::make_unique<WillyGame>();
+  Gtk::Window &game_window = game->get_game_window();
 
   // Start the game at the intro screen
-  game_window->show_all();
-  game_window->present();
+  game_window.show_all();
+  game_window.present();
 
   // Run a local event loop until the game window is closed
-  while (game_window->get_visible()) {
+  while (game_window.get_visible()) {
     // Process GTK events
     while (Gtk::Main::events_pending()) {
       Gtk::Main::iteration();
@@ -0,0 +1,299 @@
+#include "pixels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIXELS_X86 1
+#include <immintrin.h>
+#endif
+
+uint32_t argb_from_rgb(double r, double g, double b) {
+  auto channel = [](double v) {
+    return static_cast<uint32_t>(std::lround(std::clamp(v, 0.0, 1.0) * 255.0));
+  };
+  return 0xFF000000u | (channel(r) << 16) | (channel(g) << 8) | channel(b);
+}
+
+// For every mask byte, 8 bytes of 0xFF/0x00 in pixel order (leftmost first)
+static const uint64_t *byte_masks() {
+  static const std::vector<uint64_t> table = []() {
+    std::vector<uint64_t> masks(256);
+    for (int value = 0; value < 256; value++) {
+      uint8_t bytes[8];
+      for (int j = 0; j < 8; j++) {
+        bytes[j] = ((value >> (7 - j)) & 1) ? 0xFF : 0x00;
+      }
+      memcpy(&masks[value], bytes, sizeof(bytes));
+    }
+    return masks;
+  }();
+  return table.data();
+}
+
+IndexedFramebuffer::IndexedFramebuffer(int width, int height)
+    : width(0), height(0) {
+  for (int i = 0; i < PALETTE_SIZE; i++) {
+    palette[i] = 0xFFFFFFFFu;
+  }
+  palette[PALETTE_BACKGROUND] = 0xFF000000u;
+  resize(width, height);
+}
+
+void IndexedFramebuffer::resize(int new_width, int new_height) {
+  width = std::max(0, new_width);
+  height = std::max(0, new_height);
+  pixels.assign(static_cast<size_t>(width) * height, PALETTE_BACKGROUND);
+}
+
+void IndexedFramebuffer::clear(uint8_t index) {
+  std::fill(pixels.begin(), pixels.end(), index);
+}
+
+void IndexedFramebuffer::draw_glyph(int x, int y, const uint32_t *rows,
+                                    int size, uint8_t index) {
+  const uint64_t *masks = byte_masks();
+  const uint64_t fill = 0x0101010101010101ull * index;
+
+  for (int r = 0; r < size; r++) {
+    int py = y + r;
+    if (py < 0 || py >= height)
+      continue;
+
+    uint8_t *dst = &pixels[static_cast<size_t>(py) * width];
+    uint32_t bits = rows[r];
+
+    // Eight pixels at a time through the byte mask table
+    for (int chunk = 0; chunk < size; chunk += 8) {
+      uint8_t byte = (bits >> (size - 8 - chunk)) & 0xFF;
+      if (!byte)
+        continue;
+
+      int px = x + chunk;
+      if (px >= 0 && px + 8 <= width) {
+        uint64_t mask = masks[byte];
+        uint64_t current;
+        memcpy(&current, dst + px, 8);
+        current = (current & ~mask) | (fill & mask);
+        memcpy(dst + px, &current, 8);
+      } else {
+        for (int j = 0; j < 8; j++) {
+          int cx = px + j;
+          if (((byte >> (7 - j)) & 1) && cx >= 0 && cx < width) {
+            dst[cx] = index;
+          }
+        }
+      }
+    }
+  }
+}
+
+void IndexedFramebuffer::set_palette(uint8_t index, uint32_t argb) {
+  palette[index % PALETTE_SIZE] = argb;
+}
+
+uint32_t IndexedFramebuffer::get_palette(uint8_t index) const {
+  return palette[index % PALETTE_SIZE];
+}
+
+static void expand_row_scalar(const uint8_t *src, uint32_t *dst, int first,
+                              int count, const uint32_t *palette) {
+  for (int x = first; x < count; x++) {
+    dst[x] = palette[src[x] & (PALETTE_SIZE - 1)];
+  }
+}
+
+#ifdef PIXELS_X86
+// Sixteen pixels per step: the palette is split into B, G, R and A byte
+// tables and looked up with pshufb, then re-interleaved into ARGB32
+__attribute__((target("ssse3"))) static int
+expand_row_ssse3(const uint8_t *src, uint32_t *dst, int count,
+                 const uint32_t *palette) {
+  alignas(16) uint8_t planes[4][16];
+  for (int i = 0; i < 16; i++) {
+    for (int c = 0; c < 4; c++) {
+      planes[c][i] = (palette[i] >> (8 * c)) & 0xFF;
+    }
+  }
+  const __m128i tb = _mm_load_si128(reinterpret_cast<const __m128i *>(planes[0]));
+  const __m128i tg = _mm_load_si128(reinterpret_cast<const __m128i *>(planes[1]));
+  const __m128i tr = _mm_load_si128(reinterpret_cast<const __m128i *>(planes[2]));
+  const __m128i ta = _mm_load_si128(reinterpret_cast<const __m128i *>(planes[3]));
+  const __m128i low_nibble = _mm_set1_epi8(0x0F);
+
+  int done = count & ~15;
+  for (int x = 0; x < done; x += 16) {
+    __m128i idx = _mm_and_si128(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x)),
+        low_nibble);
+    __m128i b = _mm_shuffle_epi8(tb, idx);
+    __m128i g = _mm_shuffle_epi8(tg, idx);
+    __m128i r = _mm_shuffle_epi8(tr, idx);
+    __m128i a = _mm_shuffle_epi8(ta, idx);
+
+    __m128i bg_lo = _mm_unpacklo_epi8(b, g), bg_hi = _mm_unpackhi_epi8(b, g);
+    __m128i ra_lo = _mm_unpacklo_epi8(r, a), ra_hi = _mm_unpackhi_epi8(r, a);
+
+    __m128i *out = reinterpret_cast<__m128i *>(dst + x);
+    _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(bg_lo, ra_lo));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bg_lo, ra_lo));
+    _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(bg_hi, ra_hi));
+    _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(bg_hi, ra_hi));
+  }
+  return done;
+}
+
+// Eight pixels per step: two in-register 8-entry lookups, picked by bit 3
+__attribute__((target("avx2"))) static int
+expand_row_avx2(const uint8_t *src, uint32_t *dst, int count,
+                const uint32_t *palette) {
+  const __m256i pal_lo =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(palette));
+  const __m256i pal_hi =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(palette + 8));
+
+  int done = count & ~7;
+  for (int x = 0; x < done; x += 8) {
+    __m256i idx = _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + x)));
+    __m256i lo = _mm256_permutevar8x32_epi32(pal_lo, idx);
+    __m256i hi = _mm256_permutevar8x32_epi32(pal_hi, idx);
+    __m256 use_hi = _mm256_castsi256_ps(_mm256_slli_epi32(idx, 28));
+    __m256i px = _mm256_castps_si256(_mm256_blendv_ps(
+        _mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi), use_hi));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), px);
+  }
+  return done;
+}
+#endif // PIXELS_X86
+
+static void expand_row(const uint8_t *src, uint32_t *dst, int count,
+                       const uint32_t *palette, SimdLevel level) {
+  int done = 0;
+#ifdef PIXELS_X86
+  if (level == SimdLevel::AVX2) {
+    done = expand_row_avx2(src, dst, count, palette);
+  } else if (level == SimdLevel::SSSE3) {
+    done = expand_row_ssse3(src, dst, count, palette);
+  }
+#else
+  (void)level;
+#endif
+  expand_row_scalar(src, dst, done, count, palette);
+}
+
+static int widen_row_scalar(const uint32_t *src, int first, int count,
+                            int factor, uint32_t *dst) {
+  for (int x = first; x < count; x++) {
+    uint32_t pixel = src[x];
+    uint32_t *out = dst + x * factor;
+    for (int k = 0; k < factor; k++) {
+      out[k] = pixel;
+    }
+  }
+  return count;
+}
+
+#ifdef PIXELS_X86
+#ifdef __SSE2__
+// Broadcast each pixel and store it in blocks of four; a block may spill
+// into the next pixel's span, which is then overwritten. The last pixel is
+// left to the scalar loop so nothing is written past the row.
+static int widen_row_sse2(const uint32_t *src, int count, int factor,
+                          uint32_t *dst) {
+  int done = count - 1;
+  for (int x = 0; x < done; x++) {
+    __m128i pixel = _mm_set1_epi32(static_cast<int>(src[x]));
+    uint32_t *out = dst + x * factor;
+    for (int k = 0; k < factor; k += 4) {
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k), pixel);
+    }
+  }
+  return std::max(done, 0);
+}
+#endif
+
+// Eight source pixels become factor vectors of eight output pixels, each a
+// fixed permutation of the source vector
+__attribute__((target("avx2"))) static int
+widen_row_avx2(const uint32_t *src, int count, int factor, uint32_t *dst) {
+  if (factor > 32)
+    return 0;
+
+  __m256i lanes[32];
+  for (int k = 0; k < factor; k++) {
+    alignas(32) int32_t idx[8];
+    for (int j = 0; j < 8; j++) {
+      idx[j] = (8 * k + j) / factor;
+    }
+    lanes[k] = _mm256_load_si256(reinterpret_cast<const __m256i *>(idx));
+  }
+
+  int done = count & ~7;
+  for (int x = 0; x < done; x += 8) {
+    __m256i pixels =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + x));
+    __m256i *out = reinterpret_cast<__m256i *>(dst + x * factor);
+    for (int k = 0; k < factor; k++) {
+      _mm256_storeu_si256(out + k,
+                          _mm256_permutevar8x32_epi32(pixels, lanes[k]));
+    }
+  }
+  return done;
+}
+#endif // PIXELS_X86
+
+static void widen_row(const uint32_t *src, int count, int factor,
+                      uint32_t *dst, SimdLevel level) {
+  int done = 0;
+#ifdef PIXELS_X86
+  if (level == SimdLevel::AVX2) {
+    done = widen_row_avx2(src, count, factor, dst);
+  }
+#ifdef __SSE2__
+  else if (level >= SimdLevel::SSE2) {
+    done = widen_row_sse2(src, count, factor, dst);
+  }
+#endif
+#else
+  (void)level;
+#endif
+  widen_row_scalar(src, done, count, factor, dst);
+}
+
+void IndexedFramebuffer::expand(uint32_t *dst, int dst_stride) const {
+  SimdLevel level = detect_simd_level();
+
+  for (int y = 0; y < height; y++) {
+    uint32_t *row = reinterpret_cast<uint32_t *>(
+        reinterpret_cast<uint8_t *>(dst) + static_cast<size_t>(y) * dst_stride);
+    expand_row(&pixels[static_cast<size_t>(y) * width], row, width, palette,
+               level);
+  }
+}
+
+void IndexedFramebuffer::expand_scaled(uint32_t *dst, int dst_stride,
+                                       int factor) const {
+  if (factor <= 1) {
+    expand(dst, dst_stride);
+    return;
+  }
+
+  SimdLevel level = detect_simd_level();
+  std::vector<uint32_t> line(width);
+  size_t row_bytes = static_cast<size_t>(width) * factor * sizeof(uint32_t);
+
+  for (int y = 0; y < height; y++) {
+    expand_row(&pixels[static_cast<size_t>(y) * width], line.data(), width,
+               palette, level);
+
+    // Widen once, then copy the finished line down the rest of the block
+    uint8_t *first = reinterpret_cast<uint8_t *>(dst) +
+                     static_cast<size_t>(y) * factor * dst_stride;
+    widen_row(line.data(), width, factor, reinterpret_cast<uint32_t *>(first),
+              level);
+    for (int k = 1; k < factor; k++) {
+      memcpy(first + static_cast<size_t>(k) * dst_stride, first, row_bytes);
+    }
+  }
+}
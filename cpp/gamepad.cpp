@@ -0,0 +1,231 @@
+#include "willy.h"
+
+// Controllers are read on their own thread so a stick or button change is
+// noticed within a couple of milliseconds, whatever the GTK thread is doing.
+// Each binding turns one button or stick direction into a key, and the keys
+// go through the same path as the keyboard.
+
+namespace {
+const int POLL_INTERVAL_MS = 2;
+const int SCAN_INTERVAL_MS = 250;   // When no controller is attached
+const int RESCAN_EVERY_POLLS = 500; // When one is
+const int AXIS_MAX = 32767;
+} // namespace
+
+GamepadInput::GamepadInput(const std::vector<Binding> &bindings,
+                           int deadzone_percent)
+    : bindings(bindings) {
+  deadzone_percent = std::max(1, std::min(95, deadzone_percent));
+  deadzone = AXIS_MAX * deadzone_percent / 100;
+}
+
+GamepadInput::~GamepadInput() { stop(); }
+
+std::vector<GamepadInput::Binding> GamepadInput::default_bindings() {
+  std::vector<Binding> bindings;
+  parse_bindings("dpup=Up,dpdown=Down,dpleft=Left,dpright=Right,"
+                 "lefty-=Up,lefty+=Down,leftx-=Left,leftx+=Right,"
+                 "a=space,b=space,start=Return,back=p",
+                 bindings);
+  return bindings;
+}
+
+bool GamepadInput::parse_bindings(const std::string &spec,
+                                  std::vector<Binding> &bindings) {
+  std::stringstream items(spec);
+  std::string item;
+  while (std::getline(items, item, ',')) {
+    if (item.empty()) {
+      continue;
+    }
+    size_t equals = item.find('=');
+    if (equals == std::string::npos) {
+      std::cerr << "Error: Gamepad binding must be INPUT=KEY: " << item
+                << "\n";
+      return false;
+    }
+    std::string input = item.substr(0, equals);
+    std::string key = item.substr(equals + 1);
+
+    Binding binding;
+    char last = input.empty() ? '\0' : input.back();
+    if (last == '+' || last == '-') {
+      std::string axis_name = input.substr(0, input.size() - 1);
+      binding.axis = SDL_GameControllerGetAxisFromString(axis_name.c_str());
+      binding.sign = (last == '+') ? 1 : -1;
+      if (binding.axis == SDL_CONTROLLER_AXIS_INVALID) {
+        std::cerr << "Error: Unknown gamepad axis: " << axis_name << "\n";
+        return false;
+      }
+    } else {
+      binding.button = SDL_GameControllerGetButtonFromString(input.c_str());
+      if (binding.button == SDL_CONTROLLER_BUTTON_INVALID) {
+        std::cerr << "Error: Unknown gamepad button: " << input << "\n";
+        return false;
+      }
+    }
+
+    // "none" removes a default binding
+    if (key != "none") {
+      binding.keyval = gdk_keyval_from_name(key.c_str());
+      if (binding.keyval == GDK_KEY_VoidSymbol || binding.keyval == 0) {
+        std::cerr << "Error: Unknown key name: " << key << "\n";
+        return false;
+      }
+    }
+
+    auto same_input = [&binding](const Binding &other) {
+      return other.button == binding.button && other.axis == binding.axis &&
+             other.sign == binding.sign;
+    };
+    bindings.erase(
+        std::remove_if(bindings.begin(), bindings.end(), same_input),
+        bindings.end());
+    if (binding.keyval != 0) {
+      bindings.push_back(binding);
+    }
+  }
+  return true;
+}
+
+bool GamepadInput::start(std::function<void()> on_input) {
+  // A cabinet's window may not have focus, but the sticks should still work
+  {
+    std::lock_guard<std::mutex> lock(sdl_subsystem_mutex);
+    SDL_SetHint(SDL_HINT_JOYSTICK_ALLOW_BACKGROUND_EVENTS, "1");
+    if (SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER) < 0) {
+      std::cout << "Warning: Gamepad support could not initialize! "
+                   "SDL_Error: "
+                << SDL_GetError() << std::endl;
+      return false;
+    }
+  }
+  initialized = true;
+
+  // The poller reads controller state directly; queued SDL events would only
+  // pile up unread
+  SDL_GameControllerEventState(SDL_IGNORE);
+  SDL_JoystickEventState(SDL_IGNORE);
+
+  notify = on_input;
+  stopping = false;
+  poller = std::thread(&GamepadInput::poll_loop, this);
+  return true;
+}
+
+void GamepadInput::stop() {
+  if (poller.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(stop_mutex);
+      stopping = true;
+    }
+    stop_requested.notify_one();
+    poller.join();
+  }
+  for (auto &entry : controllers) {
+    SDL_GameControllerClose(entry.second);
+  }
+  controllers.clear();
+  if (initialized) {
+    std::lock_guard<std::mutex> lock(sdl_subsystem_mutex);
+    SDL_QuitSubSystem(SDL_INIT_GAMECONTROLLER);
+    initialized = false;
+  }
+}
+
+// Opens controllers that were plugged in and closes ones that went away
+void GamepadInput::scan_controllers() {
+  for (auto it = controllers.begin(); it != controllers.end();) {
+    if (!SDL_GameControllerGetAttached(it->second)) {
+      std::cout << "Gamepad disconnected: "
+                << SDL_GameControllerName(it->second) << std::endl;
+      SDL_GameControllerClose(it->second);
+      it = controllers.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  for (int i = 0; i < SDL_NumJoysticks(); i++) {
+    if (!SDL_IsGameController(i) ||
+        controllers.count(SDL_JoystickGetDeviceInstanceID(i))) {
+      continue;
+    }
+    SDL_GameController *controller = SDL_GameControllerOpen(i);
+    if (!controller) {
+      continue;
+    }
+    SDL_JoystickID id =
+        SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(controller));
+    controllers[id] = controller;
+    std::cout << "Gamepad connected: " << SDL_GameControllerName(controller)
+              << std::endl;
+  }
+}
+
+bool GamepadInput::is_pushed(SDL_GameController *controller,
+                             const Binding &binding) const {
+  if (binding.button >= 0) {
+    return SDL_GameControllerGetButton(
+               controller, (SDL_GameControllerButton)binding.button) != 0;
+  }
+
+  int value = SDL_GameControllerGetAxis(controller,
+                                        (SDL_GameControllerAxis)binding.axis);
+  // Letting go needs a little more travel than pushing, so a stick resting
+  // on the edge of the deadzone doesn't chatter
+  int threshold = binding.active ? deadzone * 3 / 4 : deadzone;
+  return value * binding.sign > threshold;
+}
+
+void GamepadInput::poll_loop() {
+  int polls_until_scan = 0;
+
+  while (!stopping) {
+    SDL_GameControllerUpdate();
+    if (controllers.empty() || --polls_until_scan <= 0) {
+      scan_controllers();
+      polls_until_scan = RESCAN_EVERY_POLLS;
+    }
+
+    // A binding is held while any controller holds it, so an unplugged
+    // controller releases whatever it was holding. A key is held while any
+    // binding for it is, so the d-pad and the stick don't fight.
+    bool queued = false;
+    gint64 now = g_get_monotonic_time();
+    for (auto &binding : bindings) {
+      bool pushed = false;
+      for (auto &entry : controllers) {
+        pushed = pushed || is_pushed(entry.second, binding);
+      }
+      if (pushed == binding.active) {
+        continue;
+      }
+      binding.active = pushed;
+
+      int &holds = key_holds[binding.keyval];
+      holds += pushed ? 1 : -1;
+      if (holds != (pushed ? 1 : 0)) {
+        continue;
+      }
+
+      InputEvent event;
+      event.type = pushed ? InputEvent::KEY_PRESS : InputEvent::KEY_RELEASE;
+      event.keyval = binding.keyval;
+      event.time = now;
+      if (events.push(event)) {
+        queued = true;
+      }
+    }
+    if (queued && notify) {
+      notify();
+    }
+
+    std::unique_lock<std::mutex> lock(stop_mutex);
+    stop_requested.wait_for(
+        lock,
+        std::chrono::milliseconds(controllers.empty() ? SCAN_INTERVAL_MS
+                                                      : POLL_INTERVAL_MS),
+        [this]() { return stopping; });
+  }
+}
@@ -20,8 +20,7 @@ HighScoreManager::HighScoreManager() {
     permanent_scores.push_back({"nobody", 0});
     daily_scores.push_back({"nobody", 0});
   }
-
-  load_scores();
+  // load_scores() is left to the caller so it can run in the background
 }
 
 HighScoreManager::~HighScoreManager() { save_scores(); }
@@ -86,6 +85,9 @@ void HighScoreManager::load_scores() {
     buffer << file.rdbuf();
     std::string json_content = buffer.str();
 
+    // The file is read unlocked; the tables may already be on screen
+    std::lock_guard<std::mutex> lock(mutex);
+    version++;
     if (json_content.empty()) {
       return;
     }
@@ -250,14 +252,18 @@ HighScore HighScoreManager::parse_score_line(const std::string &line) {
 }
 
 bool HighScoreManager::is_high_score(int score) {
+  std::lock_guard<std::mutex> lock(mutex);
   return score > daily_scores.back().score;
 }
 
 bool HighScoreManager::is_permanent_high_score(int score) {
+  std::lock_guard<std::mutex> lock(mutex);
   return score > permanent_scores.back().score;
 }
 
 void HighScoreManager::add_score(const std::string &name, int score) {
+  std::lock_guard<std::mutex> lock(mutex);
+
   // Add to daily scores
   daily_scores.push_back({name, score});
   std::sort(
@@ -271,6 +277,7 @@ void HighScoreManager::add_score(const std::string &name, int score) {
       permanent_scores.begin(), permanent_scores.end(),
       [](const HighScore &a, const HighScore &b) { return a.score > b.score; });
   permanent_scores.resize(10); // Keep only top 10
+  version++;
 
   save_scores();
 }
@@ -295,162 +302,114 @@ std::string HighScoreManager::get_score_description(int score) {
 }
 
 std::string HighScoreManager::get_achievement_message(int score) {
-  if (is_permanent_high_score(score)) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (score > permanent_scores.back().score) {
     return "You're an Official Nightcrawler!";
-  } else if (is_high_score(score)) {
+  } else if (score > daily_scores.back().score) {
     return "You're a Daily Pinworm!";
   }
   return "";
 }
 
 std::vector<HighScore> HighScoreManager::get_permanent_scores() const {
+  std::lock_guard<std::mutex> lock(mutex);
   return permanent_scores;
 }
 
 std::vector<HighScore> HighScoreManager::get_daily_scores() const {
+  std::lock_guard<std::mutex> lock(mutex);
   return daily_scores;
 }
 
 void WillyGame::draw_high_score_entry_screen(
     const Cairo::RefPtr<Cairo::Context> &cr) {
-  // Get menubar height to use as offset
-  Gtk::Requisition menubar_min, menubar_nat;
-  menubar.get_preferred_size(menubar_min, menubar_nat);
-  int menubar_height = menubar_min.height;
+  int menubar_height = viewport.menubar_height;
 
   // Blue background
   cr->set_source_rgb(0.0, 0.0, 1.0);
   cr->paint();
 
-  // Create font
-  Pango::FontDescription font_desc;
-  font_desc.set_family("Courier");
-  font_desc.set_size(20 * PANGO_SCALE);
-
-  auto layout = create_pango_layout("");
-  layout->set_font_description(font_desc);
-
-  cr->set_source_rgb(1.0, 1.0, 1.0); // White text
+  BitmapFont &font = get_font("Courier", 20);
+  int screen_width = GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor;
 
   int y_offset = menubar_height + 50;
   int line_height = 35;
 
   // Achievement message
-  std::string achievement = score_manager->get_achievement_message(score);
+  std::string achievement =
+      score_manager->get_achievement_message(view->score);
   if (!achievement.empty()) {
-    layout->set_text(achievement);
-    int text_width, text_height;
-    layout->get_pixel_size(text_width, text_height);
-    int x_offset =
-        (GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor - text_width) / 2;
-    cr->move_to(x_offset, y_offset);
-    layout->show_in_cairo_context(cr);
+    int x_offset = (screen_width - font.measure(achievement)) / 2;
+    font.draw_text(cr, x_offset, y_offset, achievement, 1.0, 1.0, 1.0);
     y_offset += line_height * 2;
   }
 
   // Score description
-  std::string description = score_manager->get_score_description(score);
-  layout->set_text(description);
-  int text_width, text_height;
-  layout->get_pixel_size(text_width, text_height);
-  int x_offset =
-      (GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor - text_width) / 2;
-  cr->move_to(x_offset, y_offset);
-  layout->show_in_cairo_context(cr);
+  std::string description =
+      score_manager->get_score_description(view->score);
+  int x_offset = (screen_width - font.measure(description)) / 2;
+  font.draw_text(cr, x_offset, y_offset, description, 1.0, 1.0, 1.0);
   y_offset += line_height * 2;
 
   // Score
   std::string score_text =
-      "Your score for this game is " + std::to_string(score) + "...";
-  layout->set_text(score_text);
-  layout->get_pixel_size(text_width, text_height);
-  x_offset =
-      (GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor - text_width) / 2;
-  cr->move_to(x_offset, y_offset);
-  layout->show_in_cairo_context(cr);
+      "Your score for this game is " + std::to_string(view->score) + "...";
+  x_offset = (screen_width - font.measure(score_text)) / 2;
+  font.draw_text(cr, x_offset, y_offset, score_text, 1.0, 1.0, 1.0);
   y_offset += line_height * 2;
 
   // Name entry prompt
-  std::string prompt = "Enter your name >> " + name_input;
-  layout->set_text(prompt);
-  layout->get_pixel_size(text_width, text_height);
-  x_offset =
-      (GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor - text_width) / 2;
-  cr->move_to(x_offset, y_offset);
-  layout->show_in_cairo_context(cr);
+  std::string prompt = "Enter your name >> " + view->name_input;
+  x_offset = (screen_width - font.measure(prompt)) / 2;
+  font.draw_text(cr, x_offset, y_offset, prompt, 1.0, 1.0, 1.0);
 }
 
 void WillyGame::draw_high_score_display_screen(
     const Cairo::RefPtr<Cairo::Context> &cr) {
-  // Get menubar height to use as offset
-  Gtk::Requisition menubar_min, menubar_nat;
-  menubar.get_preferred_size(menubar_min, menubar_nat);
-  int menubar_height = menubar_min.height;
+  int menubar_height = viewport.menubar_height;
 
   // Blue background
   cr->set_source_rgb(0.0, 0.0, 1.0);
   cr->paint();
 
-  // Create fonts
-  Pango::FontDescription header_font;
-  header_font.set_family("Courier");
-  header_font.set_size(24 * PANGO_SCALE);
-
-  Pango::FontDescription score_font;
-  score_font.set_family("Courier");
-  score_font.set_size(16 * PANGO_SCALE);
-
-  auto layout = create_pango_layout("");
+  // Fonts
+  BitmapFont &header_font = get_font("Courier", 24);
+  BitmapFont &score_font = get_font("Courier", 16);
+  int screen_width = GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor;
 
   int y_offset = menubar_height + 20;
   int line_height = 25;
 
-  // All-time Nightcrawlers header
-  layout->set_font_description(header_font);
-  cr->set_source_rgb(1.0, 1.0, 0.0); // Yellow
-  layout->set_text("All-time Nightcrawlers");
-  int text_width, text_height;
-  layout->get_pixel_size(text_width, text_height);
-  int x_offset =
-      (GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor - text_width) / 2;
-  cr->move_to(x_offset, y_offset);
-  layout->show_in_cairo_context(cr);
+  // All-time Nightcrawlers header (yellow)
+  std::string header = "All-time Nightcrawlers";
+  int x_offset = (screen_width - header_font.measure(header)) / 2;
+  header_font.draw_text(cr, x_offset, y_offset, header, 1.0, 1.0, 0.0);
   y_offset += line_height + 10;
 
   // Draw black background for table
-  int table_width = GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor / 2;
-  int table_x =
-      (GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor - table_width) / 2;
+  int table_width = screen_width / 2;
+  int table_x = (screen_width - table_width) / 2;
   cr->set_source_rgb(0.0, 0.0, 0.0);
   cr->rectangle(table_x, y_offset, table_width, line_height * 10);
   cr->fill();
 
   // Permanent scores
-  layout->set_font_description(score_font);
-  cr->set_source_rgb(1.0, 1.0, 0.0); // Yellow
   auto permanent_scores = score_manager->get_permanent_scores();
   for (int i = 0; i < 10 && i < (int)permanent_scores.size(); i++) {
     std::ostringstream oss;
     oss << std::setw(2) << (i + 1) << "     " << std::setw(5)
         << permanent_scores[i].score << "     " << permanent_scores[i].name;
 
-    layout->set_text(oss.str());
-    cr->move_to(table_x + 10, y_offset);
-    layout->show_in_cairo_context(cr);
+    score_font.draw_text(cr, table_x + 10, y_offset, oss.str(), 1.0, 1.0, 0.0);
     y_offset += line_height;
   }
 
   y_offset += 30;
 
-  // Today's Best Pinworms header
-  layout->set_font_description(header_font);
-  cr->set_source_rgb(0.0, 1.0, 1.0); // Cyan
-  layout->set_text("Today's Best Pinworms");
-  layout->get_pixel_size(text_width, text_height);
-  x_offset =
-      (GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor - text_width) / 2;
-  cr->move_to(x_offset, y_offset);
-  layout->show_in_cairo_context(cr);
+  // Today's Best Pinworms header (cyan)
+  header = "Today's Best Pinworms";
+  x_offset = (screen_width - header_font.measure(header)) / 2;
+  header_font.draw_text(cr, x_offset, y_offset, header, 0.0, 1.0, 1.0);
   y_offset += line_height + 10;
 
   // Draw black background for daily table
@@ -459,29 +418,20 @@ void WillyGame::draw_high_score_display_screen(
   cr->fill();
 
   // Daily scores
-  layout->set_font_description(score_font);
-  cr->set_source_rgb(0.0, 1.0, 1.0); // Cyan
   auto daily_scores = score_manager->get_daily_scores();
   for (int i = 0; i < 10 && i < (int)daily_scores.size(); i++) {
     std::ostringstream oss;
     oss << std::setw(2) << (i + 1) << "     " << std::setw(5)
         << daily_scores[i].score << "     " << daily_scores[i].name;
 
-    layout->set_text(oss.str());
-    cr->move_to(table_x + 10, y_offset);
-    layout->show_in_cairo_context(cr);
+    score_font.draw_text(cr, table_x + 10, y_offset, oss.str(), 0.0, 1.0, 1.0);
     y_offset += line_height;
   }
 
   y_offset += 30;
 
-  // Instructions
-  layout->set_font_description(score_font);
-  cr->set_source_rgb(1.0, 1.0, 1.0); // White
-  layout->set_text("Hit any key to play again or ESC to exit");
-  layout->get_pixel_size(text_width, text_height);
-  x_offset =
-      (GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor - text_width) / 2;
-  cr->move_to(x_offset, y_offset);
-  layout->show_in_cairo_context(cr);
+  // Instructions (white)
+  std::string instructions = "Hit any key to play again or ESC to exit";
+  x_offset = (screen_width - score_font.measure(instructions)) / 2;
+  score_font.draw_text(cr, x_offset, y_offset, instructions, 1.0, 1.0, 1.0);
 }
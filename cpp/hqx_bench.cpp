@@ -0,0 +1,38 @@
+#include "pixels.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+// Times hqx_scale_glyphs over a whole glyph set. The SIMD level comes from
+// WILLY_SIMD as in the game; make bench runs this once per level.
+
+int main(int argc, char *argv[]) {
+  const char *path = argc > 1 ? argv[1] : "willy.chr";
+  std::ifstream file(path, std::ios::binary);
+  std::vector<uint8_t> glyphs((std::istreambuf_iterator<char>(file)),
+                              std::istreambuf_iterator<char>());
+  int count = glyphs.size() / 8;
+  if (count == 0) {
+    std::cerr << "Cannot read glyphs from " << path << std::endl;
+    return 1;
+  }
+
+  const int RUNS = 1000;
+  std::vector<uint32_t> out;
+  for (SpriteFilter filter : {SpriteFilter::HQ2X, SpriteFilter::HQ4X}) {
+    hqx_scale_glyphs(glyphs.data(), count, filter, out); // Warm up
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < RUNS; run++) {
+      hqx_scale_glyphs(glyphs.data(), count, filter, out);
+    }
+    double us = std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start)
+                    .count() /
+                RUNS;
+    std::cout << simd_level_name(detect_simd_level()) << " "
+              << sprite_filter_name(filter) << ": " << count << " glyphs in "
+              << us << " us" << std::endl;
+  }
+  return 0;
+}
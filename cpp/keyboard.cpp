@@ -7,48 +7,115 @@ extern double bluebg;
 
 
 bool WillyGame::on_key_press(GdkEventKey *event) {
-  std::string keyname = gdk_keyval_name(event->keyval);
-  // std::cout << "Key pressed: " << keyname << std::endl;
-  keys_pressed.insert(keyname);
+  dispatch_key_press(event->keyval, event->state, 0);
+  return true;
+}
 
-  // Check for modifier keys
-  bool ctrl_pressed = (event->state & GDK_CONTROL_MASK);
-  bool shift_pressed = (event->state & GDK_SHIFT_MASK);
-  bool alt_pressed = (event->state & GDK_MOD1_MASK);
+bool WillyGame::on_key_release(GdkEventKey *event) {
+  dispatch_key_release(event->keyval, event->state, 0);
+  return true;
+}
+
+// Keys that work the window, the control panel or the colours are handled
+// here on the GTK thread; everything else is game input. time is when the
+// key went down, or 0 for now.
+void WillyGame::dispatch_key_press(guint keyval, guint state, gint64 time) {
+  bool playing = view->state == GameState::PLAYING;
 
-  if (keyname == "Escape") {
+  if (keyval == GDK_KEY_Escape) {
     quit_game();
-  } else if (keyname == "F11") {
-    if (get_window()->get_state() & GDK_WINDOW_STATE_FULLSCREEN) {
-      unfullscreen();
+  } else if (keyval == GDK_KEY_F11) {
+    renderer->toggle_fullscreen();
+  } else if (playing && keyval == GDK_KEY_F1) {
+    // Show/hide the control panel
+    show_control_panel();
+  } else if (playing && keyval == GDK_KEY_F5) {
+    redbg += 0.25;
+    if (redbg > 1.0) {
+      redbg = 0.0;
+    }
+  } else if (playing && keyval == GDK_KEY_F6) {
+    greenbg += 0.25;
+    if (greenbg > 1.0) {
+      greenbg = 0.0;
+    }
+  } else if (playing && keyval == GDK_KEY_F7) {
+    bluebg += 0.25;
+    if (bluebg > 1.0) {
+      bluebg = 0.0;
+    }
+  } else {
+    InputEvent input;
+    input.type = InputEvent::KEY_PRESS;
+    input.keyval = keyval;
+    input.state = state;
+    input.time = time;
+    send_input(input);
+  }
+}
+
+void WillyGame::dispatch_key_release(guint keyval, guint state, gint64 time) {
+  InputEvent input;
+  input.type = InputEvent::KEY_RELEASE;
+  input.keyval = keyval;
+  input.state = state;
+  input.time = time;
+  send_input(input);
+}
+
+// Runs on the GTK thread whenever the gamepad thread has queued key changes
+void WillyGame::on_gamepad_input() {
+  InputEvent event;
+  while (gamepad && gamepad->pop(event)) {
+    if (event.type == InputEvent::KEY_PRESS) {
+      dispatch_key_press(event.keyval, 0, event.time);
     } else {
-      fullscreen();
+      dispatch_key_release(event.keyval, 0, event.time);
     }
-  } else if (current_state == GameState::INTRO) {
-    if (keyname == "Return" || keyname == "Enter" || keyname == "KP_Enter") {
+  }
+}
+
+static bool is_enter(guint keyval) {
+  return keyval == GDK_KEY_Return || keyval == GDK_KEY_KP_Enter;
+}
+
+void WillyGame::handle_key_press(guint keyval, guint state) {
+  // std::cout << "Key pressed: " << gdk_keyval_name(keyval) << std::endl;
+  keys_held.set(keyval);
+  guint key = gdk_keyval_to_lower(keyval);
+
+  // Check for modifier keys
+  bool ctrl_pressed = (state & GDK_CONTROL_MASK);
+
+  if (current_state == GameState::INTRO) {
+    if (is_enter(keyval)) {
       std::cout << "Starting game..." << std::endl;
       start_game();
     }
   } else if (current_state == GameState::PLAYING) {
-    if (keyname == "space") {
+    keys_tapped.set(keyval);
+    if (keyval == GDK_KEY_space) {
       jump();
-    } else if (keyname == "Left" || (game_options.use_wasd && keyname == "a")) {
+    } else if (keyval == GDK_KEY_Left ||
+               (game_options.use_wasd && key == GDK_KEY_a)) {
       continuous_direction = "LEFT";
       moving_continuously = true;
       willy_direction = "LEFT";
-    } else if (keyname == "Right" ||
-               (game_options.use_wasd && keyname == "d")) {
+    } else if (keyval == GDK_KEY_Right ||
+               (game_options.use_wasd && key == GDK_KEY_d)) {
       continuous_direction = "RIGHT";
       moving_continuously = true;
       willy_direction = "RIGHT";
-    } else if (keyname == "Up" || (game_options.use_wasd && keyname == "w")) {
-      up_pressed = true;
-    } else if (keyname == "Down" || (game_options.use_wasd && keyname == "s")) {
-      down_pressed = true;
-    } else if ((keyname == "L" || keyname == "l") && ctrl_pressed) {
+    } else if (keyval == GDK_KEY_Up || keyval == GDK_KEY_Down ||
+               (game_options.use_wasd &&
+                (key == GDK_KEY_w || key == GDK_KEY_s))) {
+      // Climbing reads keys_held and keys_tapped on the next tick
+    } else if (key == GDK_KEY_p && !ctrl_pressed) {
+      pause_game();
+    } else if (key == GDK_KEY_l && ctrl_pressed) {
       // Level skip with Ctrl+L (matching Python version)
       complete_level_nobonus();
-    } else if ((keyname == "S" || keyname == "s") && ctrl_pressed) {
+    } else if (key == GDK_KEY_s && ctrl_pressed) {
       // Sound toggle with Ctrl+S
       bool current_sound_state = sound_manager->is_sound_enabled();
       sound_manager->set_sound_enabled(!current_sound_state);
@@ -59,71 +126,44 @@ bool WillyGame::on_key_press(GdkEventKey *event) {
 
       // Optional: Play a test sound when enabling
       if (!current_sound_state) {
-        sound_manager->play_sound("bell.mp3");
-      }
-    } else if (keyname == "F1") {
-       // Show/hide the control panel
-       show_control_panel();
-    } else if (keyname == "F5") {
-      redbg += 0.25;
-      if (redbg > 1.0) {
-        redbg = 0.0;
-      }
-    } else if (keyname == "F6") {
-      greenbg += 0.25;
-      if (greenbg > 1.0) {
-        greenbg = 0.0;
-      }
-    } else if (keyname == "F7") {
-      bluebg += 0.25;
-      if (bluebg > 1.0) {
-        bluebg = 0.0;
+        sound_manager->play_sound(SoundId::BELL);
       }
     } else {
       moving_continuously = false;
       continuous_direction = "";
     }
+  } else if (current_state == GameState::PAUSED) {
+    // Any key picks up where the game left off
+    resume_game();
   } else if (current_state == GameState::GAME_OVER) {
-    if (keyname == "Return" || keyname == "Enter" || keyname == "KP_Enter") {
+    if (is_enter(keyval)) {
       current_state = GameState::INTRO;
     }
   } else if (current_state == GameState::HIGH_SCORE_ENTRY) {
-    if (keyname == "Return" || keyname == "Enter" || keyname == "KP_Enter") {
+    if (is_enter(keyval)) {
       if (!name_input.empty()) {
         score_manager->add_score(name_input, score);
       }
       current_state = GameState::HIGH_SCORE_DISPLAY;
-    } else if (keyname == "BackSpace") {
+    } else if (keyval == GDK_KEY_BackSpace) {
       if (!name_input.empty()) {
         name_input.pop_back();
       }
-    } else if (keyname.length() == 1) {
-      // Single character key
-      if (name_input.length() < 20) { // Limit name length
-        name_input += keyname;
+    } else {
+      // Letters and digits are the keys whose names are one character
+      const char *name = gdk_keyval_name(keyval);
+      if (name && name[0] && !name[1] &&
+          name_input.length() < 20) { // Limit name length
+        name_input += name;
       }
     }
   } else if (current_state == GameState::HIGH_SCORE_DISPLAY) {
-    if (keyname == "Escape") {
-      quit_game();
-    } else {
-      current_state = GameState::INTRO;
-    }
+    // Escape never gets here; on_key_press quits on it
+    current_state = GameState::INTRO;
   }
-
-  return true;
 }
 
-bool WillyGame::on_key_release(GdkEventKey *event) {
-  std::string keyname = gdk_keyval_name(event->keyval);
-  keys_pressed.erase(keyname);
-
-  if (keyname == "Up") {
-    up_pressed = false;
-  } else if (keyname == "Down") {
-    down_pressed = false;
-  }
-
-  return true;
+void WillyGame::handle_key_release(guint keyval) {
+  keys_held.reset(keyval);
 }
 
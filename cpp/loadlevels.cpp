@@ -32,21 +32,33 @@ std::string LevelLoader::find_levels_file(const std::string &filename) {
 bool LevelLoader::load_levels(const std::string &filename) {
   std::string levels_path = find_levels_file(filename);
 
+  // Nothing on disk; use the copy built into the game, if there is one
+  const EmbeddedAsset *embedded = nullptr;
   if (levels_path.empty()) {
-    std::cout << "ERROR: Could not find " << filename << std::endl;
-    return false;
+    embedded = find_embedded_asset(filename);
+    if (!embedded) {
+      std::cout << "ERROR: Could not find " << filename << std::endl;
+      return false;
+    }
+    levels_path = "built-in " + filename;
   }
 
   try {
-    std::ifstream file(levels_path);
-    if (!file) {
-      throw std::runtime_error("Cannot open levels file");
-    }
+    std::string json_content;
+    if (embedded) {
+      json_content.assign(reinterpret_cast<const char *>(embedded->data),
+                          embedded->size);
+    } else {
+      std::ifstream file(levels_path);
+      if (!file) {
+        throw std::runtime_error("Cannot open levels file");
+      }
 
-    // Read entire file into string
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string json_content = buffer.str();
+      // Read entire file into string
+      std::stringstream buffer;
+      buffer << file.rdbuf();
+      json_content = buffer.str();
+    }
 
     std::cout << "Successfully read " << json_content.length()
               << " characters from " << levels_path << std::endl;
@@ -483,6 +495,7 @@ bool LevelLoader::save_levels(const std::string &filename) const {
 
 void WillyGame::load_level(const std::string &level_name) {
   current_level = level_name;
+  grid_version++;
 
   // Check if level exists
   if (!level_loader->level_exists(level_name)) {
@@ -0,0 +1,141 @@
+#ifndef LOCKFREE_H
+#define LOCKFREE_H
+
+// Small lock-free helpers for handing data between threads: the simulation
+// and GTK threads, and the sound worker. TripleBuffer and SpscQueue have
+// exactly one producer and one consumer; MpscQueue takes any number of
+// producers and one consumer.
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Three slots: the writer fills its back slot and swaps it with the middle
+// one, the reader swaps its front slot with the middle one when a newer value
+// is there. Neither side ever waits and the reader always gets the latest
+// complete value.
+template <typename T> class TripleBuffer {
+private:
+  static constexpr uint8_t FRESH = 0x4;
+
+  std::array<T, 3> slots;
+  std::atomic<uint8_t> middle{1};
+  uint8_t back = 0;  // writer only
+  uint8_t front = 2; // reader only
+
+public:
+  // The slot the writer may fill; it still holds whatever it last held
+  T &write_slot() { return slots[back]; }
+
+  void publish() {
+    back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+  }
+
+  // Picks up the latest published value if there is one. Returns true when
+  // read_slot() changed.
+  bool update() {
+    if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+      return false;
+    }
+    front = middle.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+    return true;
+  }
+
+  const T &read_slot() const { return slots[front]; }
+};
+
+// Fixed-size ring of N - 1 usable entries. push() fails instead of blocking
+// when the consumer has fallen that far behind.
+template <typename T, size_t N> class SpscQueue {
+private:
+  std::array<T, N> items;
+  std::atomic<size_t> head{0}; // next to pop, owned by the consumer
+  std::atomic<size_t> tail{0}; // next to push, owned by the producer
+
+public:
+  bool push(const T &item) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t next = (t + 1) % N;
+    if (next == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    items[t] = item;
+    tail.store(next, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T &item) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = items[h];
+    head.store((h + 1) % N, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return head.load(std::memory_order_acquire) ==
+           tail.load(std::memory_order_acquire);
+  }
+};
+
+// Bounded queue for any number of producers and one consumer. Each slot
+// carries a sequence number saying whose turn it is, so producers claim slots
+// with a single compare-and-swap and never wait on each other or on the
+// consumer. N must be a power of two.
+template <typename T, size_t N> class MpscQueue {
+private:
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T item;
+  };
+
+  std::array<Slot, N> slots;
+  std::atomic<size_t> tail{0}; // next to push, shared by the producers
+  size_t head = 0;             // next to pop, consumer only
+
+public:
+  MpscQueue() {
+    for (size_t i = 0; i < N; i++) {
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Fails when the queue is full
+  bool push(const T &item) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot &slot = slots[t & (N - 1)];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      intptr_t lag = (intptr_t)sequence - (intptr_t)t;
+      if (lag == 0) {
+        if (tail.compare_exchange_weak(t, t + 1, std::memory_order_relaxed)) {
+          slot.item = item;
+          slot.sequence.store(t + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (lag < 0) {
+        return false; // The consumer hasn't freed this slot yet
+      } else {
+        t = tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool pop(T &item) {
+    Slot &slot = slots[head & (N - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != head + 1) {
+      return false;
+    }
+    item = slot.item;
+    slot.sequence.store(head + N, std::memory_order_release);
+    head++;
+    return true;
+  }
+};
+
+#endif
@@ -183,7 +183,7 @@ void WillyGame::create_menubar() {
         
         // Position it to the left of the main window
         int main_x, main_y;
-        get_position(main_x, main_y);
+        game_window->get_position(main_x, main_y);
         control_panel->move(0, 0);
         
         // Don't show it initially - let user open it with F1
@@ -210,7 +210,11 @@ void WillyGame::show_control_panel() {
 }
 
 void WillyGame::setup_ui() {
-    add(vbox);
+    Gtk::Box &vbox = game_window->vbox;
+    Gtk::DrawingArea &drawing_area = game_window->drawing_area;
+    Gtk::Label &status_bar = game_window->status_bar;
+
+    game_window->add(vbox);
     create_menubar(); // This now creates the control panel instead
     
     // Don't pack the menubar since we're using a separate window
@@ -3,25 +3,28 @@
 extern GameOptions game_options;
 
 bool WillyGame::on_button_press(GdkEventButton *event) {
-  if (!game_options.mouse_support || current_state != GameState::PLAYING) {
+  if (!game_options.mouse_support || view->state != GameState::PLAYING) {
     return false;
   }
 
-  // Debug: Print which button was pressed
-  std::cout << "Mouse button " << event->button << " pressed" << std::endl;
-
-  // Get menubar height to account for offset
-  Gtk::Requisition menubar_min, menubar_nat;
-  menubar.get_preferred_size(menubar_min, menubar_nat);
-  int menubar_height = menubar_min.height;
+  InputEvent input;
+  input.type = InputEvent::BUTTON_PRESS;
+  input.button = event->button;
+  input.x = viewport.to_game_x(event->x);
+  input.y = viewport.to_game_y(event->y);
+  send_input(input);
+  return true;
+}
 
-  // Convert mouse coordinates to game coordinates
-  double mouse_x = event->x;
-  double mouse_y = event->y - menubar_height;
+// mouse_x and mouse_y are in unscaled game pixels
+void WillyGame::handle_button_press(int button, double mouse_x,
+                                    double mouse_y) {
+  if (current_state != GameState::PLAYING) {
+    return;
+  }
 
-  // Account for scaling
-  mouse_x /= current_scale_x;
-  mouse_y /= current_scale_y;
+  // Debug: Print which button was pressed
+  std::cout << "Mouse button " << button << " pressed" << std::endl;
 
   // Convert to grid coordinates
   int scaled_char_width = GAME_CHAR_WIDTH * scale_factor;
@@ -38,7 +41,7 @@ bool WillyGame::on_button_press(GdkEventButton *event) {
             << "), Willy at (" << willy_row << ", " << willy_col << ")"
             << std::endl;
 
-  if (event->button == 1) { // Left mouse button
+  if (button == 1) { // Left mouse button
     mouse_button_held = true;
     held_button = 1;
 
@@ -82,7 +85,7 @@ bool WillyGame::on_button_press(GdkEventButton *event) {
       }
     }
 
-  } else if (event->button == 2) { // Middle mouse button - stop
+  } else if (button == 2) { // Middle mouse button - stop
     // Stop all movement
     continuous_direction = "";
     moving_continuously = false;
@@ -93,26 +96,36 @@ bool WillyGame::on_button_press(GdkEventButton *event) {
     mouse_button_held = false;
     std::cout << "Middle click - stopping Willy" << std::endl;
 
-  } else if (event->button == 3) { // Right mouse button - jump
+  } else if (button == 3) { // Right mouse button - jump
     jump();
     std::cout << "Right click - jumping" << std::endl;
 
   } else {
     // Debug: Show any other button numbers
-    std::cout << "Unknown mouse button: " << event->button << std::endl;
+    std::cout << "Unknown mouse button: " << button << std::endl;
   }
-
-  return true;
 }
 
 bool WillyGame::on_button_release(GdkEventButton *event) {
-  if (!game_options.mouse_support || current_state != GameState::PLAYING) {
+  if (!game_options.mouse_support || view->state != GameState::PLAYING) {
     return false;
   }
 
-  std::cout << "Mouse button " << event->button << " released" << std::endl;
+  InputEvent input;
+  input.type = InputEvent::BUTTON_RELEASE;
+  input.button = event->button;
+  send_input(input);
+  return true;
+}
+
+void WillyGame::handle_button_release(int button) {
+  if (current_state != GameState::PLAYING) {
+    return;
+  }
 
-  if (event->button == 1 && mouse_button_held && held_button == 1) {
+  std::cout << "Mouse button " << button << " released" << std::endl;
+
+  if (button == 1 && mouse_button_held && held_button == 1) {
     // Stop the movement that was being held
     mouse_button_held = false;
     held_button = 0;
@@ -133,12 +146,10 @@ bool WillyGame::on_button_release(GdkEventButton *event) {
 
     mouse_direction = "";
   }
-
-  return true;
 }
 
 bool WillyGame::on_motion_notify(GdkEventMotion *event) {
-  if (!game_options.mouse_support || current_state != GameState::PLAYING) {
+  if (!game_options.mouse_support || view->state != GameState::PLAYING) {
     return false;
   }
 
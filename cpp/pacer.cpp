@@ -0,0 +1,48 @@
+#include "willy.h"
+
+FramePacer::FramePacer(int max_catch_up)
+    : max_catch_up(std::max(1, max_catch_up)) {}
+
+void FramePacer::start(int ticks_per_second, int64_t now) {
+  rate = std::max(1, ticks_per_second);
+  origin = now;
+  next_tick = 1;
+  window_start = now;
+  window_ticks = 0;
+  window_lateness = 0;
+}
+
+int FramePacer::ticks_due(int64_t now) {
+  if (now < deadline(next_tick)) {
+    return 0;
+  }
+
+  // Ticks 0..last are all due by now
+  int64_t last = (now - origin) * rate / 1000000;
+  int64_t count = last - next_tick + 1;
+  window_lateness += now - deadline(last);
+
+  if (count > max_catch_up) {
+    count = max_catch_up;
+    origin = now;
+    next_tick = 1;
+  } else {
+    next_tick = last + 1;
+  }
+
+  window_ticks += count;
+  if (now - window_start >= 1000000) {
+    measured_rate = window_ticks * 1000000.0 / (now - window_start);
+    jitter_ms = window_lateness / 1000.0 / window_ticks;
+    window_start = now;
+    window_ticks = 0;
+    window_lateness = 0;
+  }
+  return count;
+}
+
+double FramePacer::get_phase(int64_t now) const {
+  int64_t previous = deadline(next_tick - 1);
+  double phase = (double)(now - previous) / (deadline(next_tick) - previous);
+  return std::max(0.0, std::min(1.0, phase));
+}
@@ -0,0 +1,370 @@
+#include "pixels.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIXELS_X86 1
+#include <immintrin.h>
+#endif
+
+SimdLevel detect_simd_level() {
+  static const SimdLevel level = []() {
+    SimdLevel best = SimdLevel::SCALAR;
+#ifdef PIXELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+      best = SimdLevel::SSE2;
+    if (__builtin_cpu_supports("ssse3"))
+      best = SimdLevel::SSSE3;
+    if (__builtin_cpu_supports("avx2"))
+      best = SimdLevel::AVX2;
+#endif
+
+    // Allow forcing a slower path for comparisons
+    const char *forced = getenv("WILLY_SIMD");
+    if (forced) {
+      if (strcmp(forced, "scalar") == 0)
+        best = SimdLevel::SCALAR;
+      else if (strcmp(forced, "sse2") == 0 && best > SimdLevel::SSE2)
+        best = SimdLevel::SSE2;
+      else if (strcmp(forced, "ssse3") == 0 && best > SimdLevel::SSSE3)
+        best = SimdLevel::SSSE3;
+    }
+    return best;
+  }();
+  return level;
+}
+
+const char *simd_level_name(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::AVX2:
+    return "avx2";
+  case SimdLevel::SSSE3:
+    return "ssse3";
+  case SimdLevel::SSE2:
+    return "sse2";
+  default:
+    return "scalar";
+  }
+}
+
+bool parse_sprite_filter(const std::string &name, SpriteFilter &filter) {
+  if (name == "nearest") {
+    filter = SpriteFilter::NEAREST;
+  } else if (name == "hq2x") {
+    filter = SpriteFilter::HQ2X;
+  } else if (name == "hq4x") {
+    filter = SpriteFilter::HQ4X;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char *sprite_filter_name(SpriteFilter filter) {
+  switch (filter) {
+  case SpriteFilter::HQ2X:
+    return "hq2x";
+  case SpriteFilter::HQ4X:
+    return "hq4x";
+  default:
+    return "nearest";
+  }
+}
+
+int sprite_filter_factor(SpriteFilter filter) {
+  switch (filter) {
+  case SpriteFilter::HQ2X:
+    return 2;
+  case SpriteFilter::HQ4X:
+    return 4;
+  default:
+    return 1;
+  }
+}
+
+// The glyphs are processed as "planes": plane r holds row r of every glyph,
+// so the rows above and below are whole vectors away and many glyphs go
+// through the Scale2x rules side by side. Rows are up to 16 pixels wide on
+// input (uint16_t lanes) and up to 32 wide on output (uint32_t lanes).
+
+// Spreads the low 16 bits so bit i lands on bit 2i
+static inline uint32_t spread_bits(uint32_t x) {
+  x = (x | (x << 8)) & 0x00FF00FFu;
+  x = (x | (x << 4)) & 0x0F0F0F0Fu;
+  x = (x | (x << 2)) & 0x33333333u;
+  x = (x | (x << 1)) & 0x55555555u;
+  return x;
+}
+
+// Scale2x on one row. P is the row, A the row above and D the row below.
+// Outside the glyph the edge pixel is repeated, as in the reference
+// algorithm.
+static inline void scale2x_row(uint32_t P, uint32_t A, uint32_t D, int width,
+                               uint32_t &top, uint32_t &bottom) {
+  uint32_t msb = 1u << (width - 1);
+  uint32_t mask = (width == 32) ? 0xFFFFFFFFu : ((1u << width) - 1);
+
+  uint32_t C = (P >> 1) | (P & msb);          // pixel to the left
+  uint32_t B = ((P << 1) & mask) | (P & 1u); // pixel to the right
+
+  uint32_t ca = C ^ A, cd = C ^ D, ab = A ^ B, bd = B ^ D;
+  uint32_t c0 = ~ca & cd & ab; // C==A && C!=D && A!=B
+  uint32_t c1 = ~ab & ca & bd; // A==B && A!=C && B!=D
+  uint32_t c2 = ~cd & bd & ca; // D==C && D!=B && C!=A
+  uint32_t c3 = ~bd & ab & cd; // B==D && B!=A && D!=C
+
+  uint32_t e0 = (c0 & A) | (~c0 & P);
+  uint32_t e1 = (c1 & B) | (~c1 & P);
+  uint32_t e2 = (c2 & C) | (~c2 & P);
+  uint32_t e3 = (c3 & D) | (~c3 & P);
+
+  top = (spread_bits(e0 & mask) << 1) | spread_bits(e1 & mask);
+  bottom = (spread_bits(e2 & mask) << 1) | spread_bits(e3 & mask);
+}
+
+static void scale2x_planes_scalar(const uint16_t *in, int rows, int width,
+                                  int count, int first, uint32_t *out) {
+  for (int r = 0; r < rows; r++) {
+    const uint16_t *P = in + r * count;
+    const uint16_t *A = in + (r > 0 ? r - 1 : r) * count;
+    const uint16_t *D = in + (r < rows - 1 ? r + 1 : r) * count;
+    uint32_t *top = out + (2 * r) * count;
+    uint32_t *bottom = out + (2 * r + 1) * count;
+
+    for (int g = first; g < count; g++) {
+      scale2x_row(P[g], A[g], D[g], width, top[g], bottom[g]);
+    }
+  }
+}
+
+#ifdef PIXELS_X86
+#ifdef __SSE2__
+static inline __m128i spread_bits_sse2(__m128i x) {
+  x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi32(x, 8)),
+                    _mm_set1_epi32(0x00FF00FF));
+  x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi32(x, 4)),
+                    _mm_set1_epi32(0x0F0F0F0F));
+  x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi32(x, 2)),
+                    _mm_set1_epi32(0x33333333));
+  x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi32(x, 1)),
+                    _mm_set1_epi32(0x55555555));
+  return x;
+}
+
+static inline __m128i select_sse2(__m128i cond, __m128i a, __m128i p) {
+  return _mm_or_si128(_mm_and_si128(cond, a), _mm_andnot_si128(cond, p));
+}
+
+// Eight glyphs per step; returns how many glyphs were handled
+static int scale2x_planes_sse2(const uint16_t *in, int rows, int width,
+                               int count, uint32_t *out) {
+  const __m128i msb = _mm_set1_epi16((short)(1u << (width - 1)));
+  const __m128i mask = _mm_set1_epi16((short)((1u << width) - 1));
+  const __m128i one = _mm_set1_epi16(1);
+  const __m128i zero = _mm_setzero_si128();
+  int done = count & ~7;
+
+  for (int r = 0; r < rows; r++) {
+    const uint16_t *pp = in + r * count;
+    const uint16_t *pa = in + (r > 0 ? r - 1 : r) * count;
+    const uint16_t *pd = in + (r < rows - 1 ? r + 1 : r) * count;
+    uint32_t *top = out + (2 * r) * count;
+    uint32_t *bottom = out + (2 * r + 1) * count;
+
+    for (int g = 0; g < done; g += 8) {
+      __m128i P = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pp + g));
+      __m128i A = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pa + g));
+      __m128i D = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pd + g));
+
+      __m128i C = _mm_or_si128(_mm_srli_epi16(P, 1), _mm_and_si128(P, msb));
+      __m128i B = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(P, 1), mask),
+                               _mm_and_si128(P, one));
+
+      __m128i ca = _mm_xor_si128(C, A), cd = _mm_xor_si128(C, D);
+      __m128i ab = _mm_xor_si128(A, B), bd = _mm_xor_si128(B, D);
+      __m128i c0 = _mm_andnot_si128(ca, _mm_and_si128(cd, ab));
+      __m128i c1 = _mm_andnot_si128(ab, _mm_and_si128(ca, bd));
+      __m128i c2 = _mm_andnot_si128(cd, _mm_and_si128(bd, ca));
+      __m128i c3 = _mm_andnot_si128(bd, _mm_and_si128(ab, cd));
+
+      __m128i e0 = select_sse2(c0, A, P);
+      __m128i e1 = select_sse2(c1, B, P);
+      __m128i e2 = select_sse2(c2, C, P);
+      __m128i e3 = select_sse2(c3, D, P);
+
+      // Widen to 32-bit lanes and interleave the pixel pairs
+      __m128i t_lo = _mm_or_si128(
+          _mm_slli_epi32(spread_bits_sse2(_mm_unpacklo_epi16(e0, zero)), 1),
+          spread_bits_sse2(_mm_unpacklo_epi16(e1, zero)));
+      __m128i t_hi = _mm_or_si128(
+          _mm_slli_epi32(spread_bits_sse2(_mm_unpackhi_epi16(e0, zero)), 1),
+          spread_bits_sse2(_mm_unpackhi_epi16(e1, zero)));
+      __m128i b_lo = _mm_or_si128(
+          _mm_slli_epi32(spread_bits_sse2(_mm_unpacklo_epi16(e2, zero)), 1),
+          spread_bits_sse2(_mm_unpacklo_epi16(e3, zero)));
+      __m128i b_hi = _mm_or_si128(
+          _mm_slli_epi32(spread_bits_sse2(_mm_unpackhi_epi16(e2, zero)), 1),
+          spread_bits_sse2(_mm_unpackhi_epi16(e3, zero)));
+
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(top + g), t_lo);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(top + g + 4), t_hi);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(bottom + g), b_lo);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(bottom + g + 4), b_hi);
+    }
+  }
+  return done;
+}
+#endif // __SSE2__
+
+__attribute__((target("avx2"))) static inline __m256i
+spread_bits_avx2(__m256i x) {
+  x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi32(x, 8)),
+                       _mm256_set1_epi32(0x00FF00FF));
+  x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi32(x, 4)),
+                       _mm256_set1_epi32(0x0F0F0F0F));
+  x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi32(x, 2)),
+                       _mm256_set1_epi32(0x33333333));
+  x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi32(x, 1)),
+                       _mm256_set1_epi32(0x55555555));
+  return x;
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+interleave_half_avx2(__m128i left, __m128i right) {
+  __m256i l = spread_bits_avx2(_mm256_cvtepu16_epi32(left));
+  __m256i r = spread_bits_avx2(_mm256_cvtepu16_epi32(right));
+  return _mm256_or_si256(_mm256_slli_epi32(l, 1), r);
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+select_avx2(__m256i cond, __m256i a, __m256i p) {
+  return _mm256_or_si256(_mm256_and_si256(cond, a),
+                         _mm256_andnot_si256(cond, p));
+}
+
+// Sixteen glyphs per step; returns how many glyphs were handled
+__attribute__((target("avx2"))) static int
+scale2x_planes_avx2(const uint16_t *in, int rows, int width, int count,
+                    uint32_t *out) {
+  const __m256i msb = _mm256_set1_epi16((short)(1u << (width - 1)));
+  const __m256i mask = _mm256_set1_epi16((short)((1u << width) - 1));
+  const __m256i one = _mm256_set1_epi16(1);
+  int done = count & ~15;
+
+  for (int r = 0; r < rows; r++) {
+    const uint16_t *pp = in + r * count;
+    const uint16_t *pa = in + (r > 0 ? r - 1 : r) * count;
+    const uint16_t *pd = in + (r < rows - 1 ? r + 1 : r) * count;
+    uint32_t *top = out + (2 * r) * count;
+    uint32_t *bottom = out + (2 * r + 1) * count;
+
+    for (int g = 0; g < done; g += 16) {
+      __m256i P =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pp + g));
+      __m256i A =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pa + g));
+      __m256i D =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pd + g));
+
+      __m256i C =
+          _mm256_or_si256(_mm256_srli_epi16(P, 1), _mm256_and_si256(P, msb));
+      __m256i B =
+          _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi16(P, 1), mask),
+                          _mm256_and_si256(P, one));
+
+      __m256i ca = _mm256_xor_si256(C, A), cd = _mm256_xor_si256(C, D);
+      __m256i ab = _mm256_xor_si256(A, B), bd = _mm256_xor_si256(B, D);
+      __m256i c0 = _mm256_andnot_si256(ca, _mm256_and_si256(cd, ab));
+      __m256i c1 = _mm256_andnot_si256(ab, _mm256_and_si256(ca, bd));
+      __m256i c2 = _mm256_andnot_si256(cd, _mm256_and_si256(bd, ca));
+      __m256i c3 = _mm256_andnot_si256(bd, _mm256_and_si256(ab, cd));
+
+      __m256i e0 = select_avx2(c0, A, P);
+      __m256i e1 = select_avx2(c1, B, P);
+      __m256i e2 = select_avx2(c2, C, P);
+      __m256i e3 = select_avx2(c3, D, P);
+
+      __m256i t_lo = interleave_half_avx2(_mm256_castsi256_si128(e0),
+                                          _mm256_castsi256_si128(e1));
+      __m256i t_hi = interleave_half_avx2(_mm256_extracti128_si256(e0, 1),
+                                          _mm256_extracti128_si256(e1, 1));
+      __m256i b_lo = interleave_half_avx2(_mm256_castsi256_si128(e2),
+                                          _mm256_castsi256_si128(e3));
+      __m256i b_hi = interleave_half_avx2(_mm256_extracti128_si256(e2, 1),
+                                          _mm256_extracti128_si256(e3, 1));
+
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(top + g), t_lo);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(top + g + 8), t_hi);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(bottom + g), b_lo);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(bottom + g + 8), b_hi);
+    }
+  }
+  return done;
+}
+#endif // PIXELS_X86
+
+// One Scale2x pass over all planes: rows x count in, 2*rows x count out
+static void scale2x_planes(const uint16_t *in, int rows, int width, int count,
+                           uint32_t *out) {
+  int done = 0;
+#ifdef PIXELS_X86
+  SimdLevel level = detect_simd_level();
+  if (level == SimdLevel::AVX2) {
+    done = scale2x_planes_avx2(in, rows, width, count, out);
+  }
+#ifdef __SSE2__
+  else if (level >= SimdLevel::SSE2) {
+    done = scale2x_planes_sse2(in, rows, width, count, out);
+  }
+#endif
+#endif
+  if (done < count) {
+    scale2x_planes_scalar(in, rows, width, count, done, out);
+  }
+}
+
+void hqx_scale_glyphs(const uint8_t *glyphs, int count, SpriteFilter filter,
+                      std::vector<uint32_t> &out) {
+  int factor = sprite_filter_factor(filter);
+  int size = 8 * factor;
+  out.assign(static_cast<size_t>(count) * size, 0);
+  if (count <= 0)
+    return;
+
+  if (factor == 1) {
+    for (int g = 0; g < count * 8; g++) {
+      out[g] = glyphs[g];
+    }
+    return;
+  }
+
+  // Transpose glyph-major bytes into row planes
+  std::vector<uint16_t> planes(8 * count);
+  for (int g = 0; g < count; g++) {
+    for (int r = 0; r < 8; r++) {
+      planes[r * count + g] = glyphs[g * 8 + r];
+    }
+  }
+
+  std::vector<uint32_t> scaled(16 * count);
+  scale2x_planes(planes.data(), 8, 8, count, scaled.data());
+  int rows = 16;
+
+  if (factor == 4) {
+    planes.resize(16 * count);
+    for (size_t i = 0; i < planes.size(); i++) {
+      planes[i] = static_cast<uint16_t>(scaled[i]);
+    }
+    scaled.resize(32 * count);
+    scale2x_planes(planes.data(), 16, 16, count, scaled.data());
+    rows = 32;
+  }
+
+  // Back to glyph-major order
+  for (int g = 0; g < count; g++) {
+    for (int r = 0; r < rows; r++) {
+      out[g * size + r] = scaled[r * count + g];
+    }
+  }
+}
@@ -0,0 +1,78 @@
+#ifndef PIXELS_H
+#define PIXELS_H
+
+// Software pixel pipeline helpers. Nothing in here depends on GTK or Cairo so
+// the same code can feed any output (Cairo surface, SDL texture, files).
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Instruction set used by the vectorized pixel loops. Picked once at startup;
+// WILLY_SIMD=scalar|sse2|ssse3 in the environment caps it (handy for timing).
+enum class SimdLevel { SCALAR, SSE2, SSSE3, AVX2 };
+
+SimdLevel detect_simd_level();
+const char *simd_level_name(SimdLevel level);
+
+// Sprite upscaling filter applied once when the glyphs are turned into sprites
+enum class SpriteFilter { NEAREST, HQ2X, HQ4X };
+
+bool parse_sprite_filter(const std::string &name, SpriteFilter &filter);
+const char *sprite_filter_name(SpriteFilter filter);
+int sprite_filter_factor(SpriteFilter filter);
+
+// Upscales a set of 8x8 1-bit glyphs (8 bytes per glyph, bit 7 is the leftmost
+// pixel, the layout of willy.chr) with Scale2x edge rules: once for HQ2X and
+// twice for HQ4X. The result holds 8*factor rows per glyph, glyph after glyph;
+// each row is packed into a uint32_t with the leftmost pixel in bit
+// (8*factor - 1). NEAREST just widens the rows.
+void hqx_scale_glyphs(const uint8_t *glyphs, int count, SpriteFilter filter,
+                      std::vector<uint32_t> &out);
+
+// Palette slots used when composing the game screen. Everything starts out
+// white on the background colour; recolouring is a palette edit.
+enum PaletteIndex : uint8_t {
+  PALETTE_BACKGROUND = 0,
+  PALETTE_TILE = 1,
+  PALETTE_WILLY = 2,
+  PALETTE_BALL = 3,
+  PALETTE_SIZE = 16
+};
+
+uint32_t argb_from_rgb(double r, double g, double b);
+
+// 8-bit indexed image the tile screen is composed into. Glyphs are stamped
+// with a palette index and the whole frame is turned into ARGB32 in one pass,
+// so changing a colour never means re-rasterizing anything.
+class IndexedFramebuffer {
+private:
+  int width;
+  int height;
+  std::vector<uint8_t> pixels;
+  uint32_t palette[PALETTE_SIZE];
+
+public:
+  IndexedFramebuffer(int width = 0, int height = 0);
+
+  void resize(int new_width, int new_height);
+  int get_width() const { return width; }
+  int get_height() const { return height; }
+  const uint8_t *get_pixels() const { return pixels.data(); }
+
+  void clear(uint8_t index);
+  // Sets the pixels of a glyph mask (rows as produced by hqx_scale_glyphs,
+  // size a multiple of 8) to index; clear mask bits are left untouched
+  void draw_glyph(int x, int y, const uint32_t *rows, int size, uint8_t index);
+
+  void set_palette(uint8_t index, uint32_t argb);
+  uint32_t get_palette(uint8_t index) const;
+
+  // Writes the frame as ARGB32 (native endian, as Cairo and SDL expect)
+  void expand(uint32_t *dst, int dst_stride) const;
+  // Same, scaled up by an integer factor with nearest-neighbour sampling;
+  // dst must hold width*factor x height*factor pixels
+  void expand_scaled(uint32_t *dst, int dst_stride, int factor) const;
+};
+
+#endif // PIXELS_H
@@ -0,0 +1,305 @@
+#include "willy.h"
+
+bool parse_render_backend(const std::string &name, RenderBackend &backend) {
+  if (name == "gtk" || name == "cairo") {
+    backend = RenderBackend::GTK;
+  } else if (name == "sdl") {
+    backend = RenderBackend::SDL;
+  } else if (name == "headless") {
+    backend = RenderBackend::HEADLESS;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char *render_backend_name(RenderBackend backend) {
+  switch (backend) {
+  case RenderBackend::SDL:
+    return "sdl";
+  case RenderBackend::HEADLESS:
+    return "headless";
+  default:
+    return "gtk";
+  }
+}
+
+// GTK
+
+GtkRenderer::GtkRenderer(Gtk::Window &window, Gtk::DrawingArea &area)
+    : window(window), area(area) {}
+
+void GtkRenderer::request_frame() { area.queue_draw(); }
+
+void GtkRenderer::get_size(int &width, int &height) const {
+  Gtk::Allocation allocation = area.get_allocation();
+  width = allocation.get_width();
+  height = allocation.get_height();
+}
+
+void GtkRenderer::toggle_fullscreen() {
+  auto gdk_window = window.get_window();
+  if (gdk_window &&
+      (gdk_window->get_state() & GDK_WINDOW_STATE_FULLSCREEN)) {
+    window.unfullscreen();
+  } else {
+    window.fullscreen();
+  }
+}
+
+// Offscreen
+
+OffscreenRenderer::OffscreenRenderer(int width, int height)
+    : width(0), height(0) {
+  resize_surface(width, height);
+}
+
+void OffscreenRenderer::resize_surface(int new_width, int new_height) {
+  new_width = std::max(1, new_width);
+  new_height = std::max(1, new_height);
+  if (surface && width == new_width && height == new_height) {
+    return;
+  }
+  width = new_width;
+  height = new_height;
+  surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
+}
+
+void OffscreenRenderer::request_frame() {
+  auto cr = Cairo::Context::create(surface);
+
+  // Not every screen covers the whole area, so start from black like the
+  // window does
+  cr->set_source_rgb(0.0, 0.0, 0.0);
+  cr->paint();
+
+  if (draw_frame) {
+    draw_frame(cr);
+  }
+  surface->flush();
+
+  present();
+}
+
+void OffscreenRenderer::get_size(int &out_width, int &out_height) const {
+  out_width = width;
+  out_height = height;
+}
+
+// SDL2
+
+SdlRenderer::SdlRenderer(int width, int height)
+    : OffscreenRenderer(width, height) {}
+
+SdlRenderer::~SdlRenderer() {
+  if (texture) {
+    SDL_DestroyTexture(texture);
+  }
+  if (sdl_renderer) {
+    SDL_DestroyRenderer(sdl_renderer);
+  }
+  if (sdl_window) {
+    SDL_DestroyWindow(sdl_window);
+  }
+  if (video_initialized) {
+    std::lock_guard<std::mutex> lock(sdl_subsystem_mutex);
+    SDL_QuitSubSystem(SDL_INIT_VIDEO);
+  }
+}
+
+bool SdlRenderer::initialize() {
+  {
+    std::lock_guard<std::mutex> lock(sdl_subsystem_mutex);
+    if (SDL_InitSubSystem(SDL_INIT_VIDEO) < 0) {
+      std::cout << "SDL video could not initialize! SDL_Error: "
+                << SDL_GetError() << std::endl;
+      return false;
+    }
+  }
+  video_initialized = true;
+
+  sdl_window = SDL_CreateWindow("Willy the Worm - C++ SDL Edition",
+                                SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                                width, height,
+                                SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
+  if (!sdl_window) {
+    std::cout << "SDL window could not be created! SDL_Error: "
+              << SDL_GetError() << std::endl;
+    return false;
+  }
+
+  // Prefer a vsynced GPU renderer, but a software one works just as well
+  // since the frame is a single texture upload
+  sdl_renderer = SDL_CreateRenderer(
+      sdl_window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+  if (!sdl_renderer) {
+    std::cout << "No accelerated SDL renderer (" << SDL_GetError()
+              << "), using software" << std::endl;
+    sdl_renderer = SDL_CreateRenderer(sdl_window, -1, SDL_RENDERER_SOFTWARE);
+  }
+  if (!sdl_renderer) {
+    std::cout << "SDL renderer could not be created! SDL_Error: "
+              << SDL_GetError() << std::endl;
+    return false;
+  }
+
+  SDL_RendererInfo info;
+  if (SDL_GetRendererInfo(sdl_renderer, &info) == 0) {
+    std::cout << "SDL renderer: " << info.name
+              << ((info.flags & SDL_RENDERER_PRESENTVSYNC) ? " (vsync)" : "")
+              << std::endl;
+  }
+
+  int output_width, output_height;
+  SDL_GetRendererOutputSize(sdl_renderer, &output_width, &output_height);
+  resize_surface(output_width, output_height);
+  return create_texture();
+}
+
+bool SdlRenderer::create_texture() {
+  if (texture) {
+    SDL_DestroyTexture(texture);
+  }
+  // Cairo's ARGB32 is native-endian 0xAARRGGBB, which is SDL's ARGB8888
+  texture = SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_ARGB8888,
+                              SDL_TEXTUREACCESS_STREAMING, width, height);
+  if (!texture) {
+    std::cout << "SDL texture could not be created! SDL_Error: "
+              << SDL_GetError() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void SdlRenderer::present() {
+  if (!texture) {
+    return;
+  }
+  SDL_UpdateTexture(texture, nullptr, surface->get_data(),
+                    surface->get_stride());
+  SDL_RenderClear(sdl_renderer);
+  SDL_RenderCopy(sdl_renderer, texture, nullptr, nullptr);
+  SDL_RenderPresent(sdl_renderer);
+}
+
+void SdlRenderer::toggle_fullscreen() {
+  fullscreen = !fullscreen;
+  SDL_SetWindowFullscreen(sdl_window,
+                          fullscreen ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0);
+}
+
+// Turns an SDL key into the GDK key event the game's handlers expect
+void SdlRenderer::handle_key(const SDL_KeyboardEvent &key) {
+  SDL_Keycode sym = key.keysym.sym;
+  guint keyval = 0;
+
+  switch (sym) {
+  case SDLK_LEFT:
+    keyval = GDK_KEY_Left;
+    break;
+  case SDLK_RIGHT:
+    keyval = GDK_KEY_Right;
+    break;
+  case SDLK_UP:
+    keyval = GDK_KEY_Up;
+    break;
+  case SDLK_DOWN:
+    keyval = GDK_KEY_Down;
+    break;
+  case SDLK_RETURN:
+    keyval = GDK_KEY_Return;
+    break;
+  case SDLK_KP_ENTER:
+    keyval = GDK_KEY_KP_Enter;
+    break;
+  case SDLK_ESCAPE:
+    keyval = GDK_KEY_Escape;
+    break;
+  case SDLK_BACKSPACE:
+    keyval = GDK_KEY_BackSpace;
+    break;
+  default:
+    if (sym >= SDLK_F1 && sym <= SDLK_F12) {
+      keyval = GDK_KEY_F1 + (sym - SDLK_F1);
+    } else if (sym >= 0x20 && sym < 0x7f) {
+      // Printable keys share their keyval with ASCII
+      keyval = sym;
+      if ((key.keysym.mod & KMOD_SHIFT) && sym >= 'a' && sym <= 'z') {
+        keyval = sym - 'a' + 'A';
+      }
+    }
+    break;
+  }
+
+  if (keyval == 0) {
+    return;
+  }
+
+  GdkEventKey event = {};
+  event.type = (key.type == SDL_KEYDOWN) ? GDK_KEY_PRESS : GDK_KEY_RELEASE;
+  event.keyval = keyval;
+  if (key.keysym.mod & KMOD_CTRL)
+    event.state |= GDK_CONTROL_MASK;
+  if (key.keysym.mod & KMOD_SHIFT)
+    event.state |= GDK_SHIFT_MASK;
+  if (key.keysym.mod & KMOD_ALT)
+    event.state |= GDK_MOD1_MASK;
+
+  if (key.type == SDL_KEYDOWN) {
+    if (key_press)
+      key_press(&event);
+  } else if (key_release) {
+    key_release(&event);
+  }
+}
+
+bool SdlRenderer::poll_events() {
+  SDL_Event event;
+  while (SDL_PollEvent(&event)) {
+    switch (event.type) {
+    case SDL_QUIT:
+      return false;
+
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+      handle_key(event.key);
+      break;
+
+    case SDL_WINDOWEVENT:
+      switch (event.window.event) {
+      case SDL_WINDOWEVENT_SIZE_CHANGED: {
+        int output_width, output_height;
+        SDL_GetRendererOutputSize(sdl_renderer, &output_width, &output_height);
+        if (output_width != width || output_height != height) {
+          resize_surface(output_width, output_height);
+          create_texture();
+        }
+        break;
+      }
+      case SDL_WINDOWEVENT_EXPOSED:
+        // Nothing changed, the window just needs the last frame again
+        present();
+        break;
+      case SDL_WINDOWEVENT_FOCUS_GAINED:
+      case SDL_WINDOWEVENT_RESTORED:
+      case SDL_WINDOWEVENT_SHOWN:
+        if (activity_changed)
+          activity_changed(true);
+        break;
+      case SDL_WINDOWEVENT_FOCUS_LOST:
+      case SDL_WINDOWEVENT_MINIMIZED:
+      case SDL_WINDOWEVENT_HIDDEN:
+        if (activity_changed)
+          activity_changed(false);
+        break;
+      default:
+        break;
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+  return true;
+}
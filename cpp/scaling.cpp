@@ -1,21 +1,48 @@
 #include "willy.h"
 
-void WillyGame::calculate_scaling_factors() {
-  // Get current window size
-  int window_width, window_height;
-  get_size(window_width, window_height);
+extern GameOptions game_options;
 
-  // Get menubar and status bar heights
-  Gtk::Requisition menubar_min, menubar_nat;
-  menubar.get_preferred_size(menubar_min, menubar_nat);
+// Recomputes the viewport, but only when the window or the render target has
+// actually changed size; size-allocate fires far more often than that.
+// Returns true if it changed.
+bool WillyGame::update_viewport() {
+  int target_width, target_height;
+  get_render_size(target_width, target_height);
+  int window_width = target_width, window_height = target_height;
+  if (game_window) {
+    game_window->get_size(window_width, window_height);
+  }
 
-  Gtk::Requisition statusbar_min, statusbar_nat;
-  status_bar.get_preferred_size(statusbar_min, statusbar_nat);
+  if (window_width == viewport.window_width &&
+      window_height == viewport.window_height &&
+      target_width == viewport.target_width &&
+      target_height == viewport.target_height) {
+    return false;
+  }
+  viewport.window_width = window_width;
+  viewport.window_height = window_height;
+  viewport.target_width = target_width;
+  viewport.target_height = target_height;
 
   // Calculate available space for the game area
-  int available_width = window_width;
-  int available_height =
-      window_height - menubar_min.height - statusbar_min.height;
+  int available_width = target_width;
+  int available_height = target_height;
+  viewport.menubar_height = 0;
+
+  // Offscreen renderers have no window chrome around the frame
+  if (!renderer || renderer->draws_in_widget()) {
+    // Get menubar and status bar heights
+    Gtk::Requisition menubar_min, menubar_nat;
+    game_window->menubar.get_preferred_size(menubar_min, menubar_nat);
+
+    Gtk::Requisition statusbar_min, statusbar_nat;
+    game_window->status_bar.get_preferred_size(statusbar_min, statusbar_nat);
+
+    available_width = window_width;
+    available_height =
+        window_height - menubar_min.height - statusbar_min.height;
+    viewport.menubar_height = menubar_min.height;
+  }
 
   // Calculate scale based on height, unless width is smaller than height
   double scale;
@@ -30,18 +57,32 @@ void WillyGame::calculate_scaling_factors() {
   // Round to nearest 0.1
   double rounded_scale = std::round(scale * 10.0) / 10.0;
 
-  // Apply the same scale to both dimensions to maintain aspect ratio
-  current_scale_x = rounded_scale;
-  current_scale_y = rounded_scale;
+  // Prefer a whole number of screen pixels per game pixel when that costs at
+  // most a tenth of the size, so the frame is a pure integer upscale. With an
+  // hq filter the glyph masks have factor pixels per game pixel, so only
+  // multiples of the factor keep them an integer upscale too.
+  int factor = sprite_filter_factor(game_options.sprite_filter);
+  double pixel_scale = scale * scale_factor;
+  int whole_scale = (int)std::floor(pixel_scale / factor) * factor;
+  if (whole_scale >= 1 && pixel_scale - whole_scale <= 0.1 * pixel_scale) {
+    rounded_scale = (double)whole_scale / scale_factor;
+  }
+
+  // Apply the same scale to both dimensions to maintain aspect ratio. Don't
+  // scale below 0.1 or above 10.0 for sanity.
+  viewport.scale = std::max(0.1, std::min(10.0, rounded_scale));
 
-  // Don't scale below 0.1 or above 10.0 for sanity
-  current_scale_x = std::max(0.1, std::min(10.0, current_scale_x));
-  current_scale_y = std::max(0.1, std::min(10.0, current_scale_y));
+  // The game sits in the top left corner, right under the menubar
+  viewport.origin_x = 0.0;
+  viewport.origin_y = viewport.menubar_height;
+  viewport.cell_width = GAME_CHAR_WIDTH * scale_factor;
+  viewport.cell_height = GAME_CHAR_HEIGHT * scale_factor;
+  return true;
 }
 
 void WillyGame::on_window_resize() {
-  calculate_scaling_factors();
-
-  // Force a redraw
-  drawing_area.queue_draw();
+  // Allocations that didn't change the size don't need a redraw
+  if (update_viewport()) {
+    game_window->drawing_area.queue_draw();
+  }
 }
@@ -0,0 +1,219 @@
+#include "willy.h"
+
+// The game logic and the drawing code only meet through GameSnapshot and
+// InputEvent. Normally both sides run on the GTK thread and the snapshot is
+// refreshed in place; with --sim-thread the logic runs on its own thread at
+// fps, reads input from an SPSC queue and publishes snapshots through a
+// triple buffer, so a slow frame never delays a tick and vice versa.
+
+void WillyGame::send_input(const InputEvent &event) {
+  if (loading) {
+    return; // No game to play yet
+  }
+  InputEvent stamped = event;
+  if (stamped.time == 0) {
+    stamped.time = g_get_monotonic_time();
+  }
+
+  if (!sim_thread.joinable()) {
+    // While ticks are running, keys and buttons wait for the next one so
+    // they're applied in order and in step with the game. Everything else,
+    // and all input on still screens, is applied straight away.
+    bool deferred = tick_mode == TickMode::RUNNING &&
+                    stamped.type != InputEvent::FOCUS_LOST &&
+                    stamped.type != InputEvent::NEW_GAME;
+    if (deferred && input_queue.push(stamped)) {
+      return;
+    }
+    drain_input();
+    handle_input(stamped);
+    wake();
+    return;
+  }
+
+  if (!input_queue.push(stamped)) {
+    std::cout << "Warning: Input queue full, dropping event" << std::endl;
+    return;
+  }
+  // Taking the lock means the notify can't land between the simulation
+  // checking the queue and going to sleep
+  { std::lock_guard<std::mutex> lock(sim_mutex); }
+  sim_wake.notify_one();
+}
+
+// Applies everything queued so far, oldest first
+void WillyGame::drain_input() {
+  InputEvent event;
+  while (input_queue.pop(event)) {
+    input_latency_total += g_get_monotonic_time() - event.time;
+    input_events_applied++;
+    handle_input(event);
+  }
+}
+
+bool WillyGame::key_down(guint keyval) const {
+  return keys_held.test(keyval) || keys_tapped.test(keyval);
+}
+
+void WillyGame::handle_input(const InputEvent &event) {
+  switch (event.type) {
+  case InputEvent::KEY_PRESS:
+    handle_key_press(event.keyval, event.state);
+    break;
+  case InputEvent::KEY_RELEASE:
+    handle_key_release(event.keyval);
+    break;
+  case InputEvent::BUTTON_PRESS:
+    handle_button_press(event.button, event.x, event.y);
+    break;
+  case InputEvent::BUTTON_RELEASE:
+    handle_button_release(event.button);
+    break;
+  case InputEvent::FOCUS_LOST:
+    // The key releases will go to some other window, so forget held keys
+    keys_held.clear();
+    keys_tapped.clear();
+    up_pressed = false;
+    down_pressed = false;
+    if (current_state == GameState::PLAYING) {
+      pause_game();
+    }
+    break;
+  case InputEvent::NEW_GAME:
+    reset_game();
+    break;
+  }
+}
+
+void WillyGame::fill_snapshot(GameSnapshot &snapshot) {
+  // The grid is a thousand strings, so only copy it when it changed
+  if (snapshot.grid_version != grid_version ||
+      snapshot.level_name != current_level || snapshot.tiles.empty()) {
+    snapshot.tiles.resize(GAME_MAX_HEIGHT * GAME_MAX_WIDTH);
+    for (int row = 0; row < GAME_MAX_HEIGHT; row++) {
+      for (int col = 0; col < GAME_MAX_WIDTH; col++) {
+        snapshot.tiles[row * GAME_MAX_WIDTH + col] = get_tile(row, col);
+      }
+    }
+    snapshot.grid_version = grid_version;
+    snapshot.level_name = current_level;
+  }
+
+  snapshot.state = current_state;
+  snapshot.balls = balls;
+  snapshot.willy_position = willy_position;
+  snapshot.willy_interp_from = willy_interp_from;
+  snapshot.willy_direction = willy_direction;
+  snapshot.score = score;
+  snapshot.bonus = bonus;
+  snapshot.level = level;
+  snapshot.lives = lives;
+  snapshot.flash_ticks_left = flash_ticks_left;
+  snapshot.flash_strobe = flash_strobe;
+  snapshot.name_input = name_input;
+  snapshot.fps = fps;
+  snapshot.tick_time = g_get_monotonic_time();
+}
+
+// Points view at the latest state. Returns true if it changed.
+bool WillyGame::refresh_view() {
+  if (loading) {
+    return false; // view stays on the blank snapshot; the splash is drawn
+  }
+  bool changed = true;
+  if (sim_thread.joinable()) {
+    changed = snapshots.update();
+    view = &snapshots.read_slot();
+  } else {
+    fill_snapshot(live_view);
+    view = &live_view;
+  }
+
+  if (changed) {
+    update_status_bar();
+  }
+  return changed;
+}
+
+void WillyGame::publish_snapshot() {
+  fill_snapshot(snapshots.write_slot());
+  snapshots.publish();
+
+  // A running GTK side picks it up on its next frame; an idle one needs a
+  // nudge
+  if (main_idle) {
+    snapshot_ready.emit();
+  }
+}
+
+void WillyGame::start_sim_thread() {
+  snapshot_ready.connect(sigc::mem_fun(*this, &WillyGame::wake));
+
+  // The thread doesn't exist yet, so this is still single-threaded
+  publish_snapshot();
+  snapshots.update();
+  view = &snapshots.read_slot();
+
+  sim_stopping = false;
+  sim_thread = std::thread(&WillyGame::sim_thread_loop, this);
+}
+
+void WillyGame::stop_sim_thread() {
+  if (!sim_thread.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(sim_mutex);
+    sim_stopping = true;
+  }
+  sim_wake.notify_one();
+  sim_thread.join();
+}
+
+void WillyGame::sim_thread_loop() {
+  FramePacer sim_pacer;
+  bool was_animating = false;
+
+  while (!sim_stopping) {
+    bool changed = false;
+    if (!input_queue.empty()) {
+      drain_input();
+      changed = true;
+    }
+
+    // Same rule as the GTK side: only PLAYING and the death flash move
+    bool animating =
+        current_state == GameState::PLAYING || flash_ticks_left > 0;
+    if (animating) {
+      if (!was_animating || sim_pacer.get_target_rate() != fps) {
+        sim_pacer.start(fps, g_get_monotonic_time());
+      }
+      int due = sim_pacer.ticks_due(g_get_monotonic_time());
+      for (int i = 0; i < due; i++) {
+        simulate_tick();
+        changed = true;
+      }
+    }
+    was_animating = animating;
+
+    if (changed) {
+      publish_snapshot();
+    }
+
+    // Sleep until the next tick, or until input arrives; on a still screen
+    // there is no next tick
+    std::unique_lock<std::mutex> lock(sim_mutex);
+    auto woken = [this]() { return sim_stopping || !input_queue.empty(); };
+    if (current_state == GameState::PLAYING || flash_ticks_left > 0) {
+      if (!was_animating) {
+        continue; // input just started the game; set up the pacer first
+      }
+      gint64 wait = sim_pacer.next_deadline() - g_get_monotonic_time();
+      sim_wake.wait_for(lock,
+                        std::chrono::microseconds(std::max<gint64>(0, wait)),
+                        woken);
+    } else {
+      sim_wake.wait(lock, woken);
+    }
+  }
+}
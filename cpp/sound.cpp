@@ -1,33 +1,154 @@
 #include "willy.h"
 
-SoundManager::SoundManager() : sound_enabled(true), initialized(false) {}
+std::mutex sdl_subsystem_mutex;
+
+bool parse_sound_mode(const std::string &name, SoundMode &mode,
+                      std::string &record_file) {
+  const std::string record_prefix = "record:";
+  if (name == "files") {
+    mode = SoundMode::FILES;
+  } else if (name == "synth") {
+    mode = SoundMode::SYNTH;
+  } else if (name == "none") {
+    mode = SoundMode::NONE;
+  } else if (name.compare(0, record_prefix.size(), record_prefix) == 0 &&
+             name.size() > record_prefix.size()) {
+    mode = SoundMode::RECORD;
+    record_file = name.substr(record_prefix.size());
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char *sound_mode_name(SoundMode mode) {
+  switch (mode) {
+  case SoundMode::SYNTH:
+    return "synth";
+  case SoundMode::NONE:
+    return "none";
+  case SoundMode::RECORD:
+    return "record";
+  default:
+    return "files";
+  }
+}
+
+const char *sound_name(SoundId id) {
+  switch (id) {
+  case SoundId::BELL:
+    return "bell";
+  case SoundId::BOOP:
+    return "boop";
+  case SoundId::JUMP:
+    return "jump";
+  case SoundId::LADDER:
+    return "ladder";
+  case SoundId::PRESENT:
+    return "present";
+  case SoundId::TACK:
+    return "tack";
+  default:
+    return "";
+  }
+}
+
+std::string sound_file_name(SoundId id) {
+  return std::string(sound_name(id)) + ".mp3";
+}
+
+namespace {
+struct SoundRule {
+  int priority; // Higher plays first and can take a channel from lower
+  int cooldown_ms;
+};
+
+// Cues the player must hear; they may even take a channel from each other
+const int IMPORTANT_PRIORITY = 3;
+
+// A sound this far behind what it goes with is dropped instead of played
+const int MAX_SOUND_DELAY_MS = 250;
+
+const SoundRule sound_rules[SOUND_COUNT] = {
+    {IMPORTANT_PRIORITY, 0}, // BELL
+    {0, 60},                 // BOOP, one per ball jumped over
+    {1, 0},                  // JUMP
+    {1, 60},                 // LADDER
+    {2, 0},                  // PRESENT
+    {IMPORTANT_PRIORITY, 0}, // TACK
+};
+} // namespace
+
+SoundManager::SoundManager(SoundMode mode, int rate, int frames)
+    : mode(mode), initialized(false), buffer_frames(frames),
+      sample_rate(rate) {}
 
 SoundManager::~SoundManager() { cleanup(); }
 
+// Starts the worker, which opens the device in the background. Only fails
+// if the worker can't be started at all.
 bool SoundManager::initialize() {
   if (initialized)
     return true;
 
-  // Initialize SDL Audio
-  if (SDL_Init(SDL_INIT_AUDIO) < 0) {
-    std::cout << "SDL Audio initialization failed: " << SDL_GetError()
+  // Posting a semaphore doesn't take a lock, so waking the worker keeps
+  // play_sound wait-free
+  commands_waiting = SDL_CreateSemaphore(0);
+  if (!commands_waiting) {
+    std::cout << "Audio worker could not start: " << SDL_GetError()
               << std::endl;
     return false;
   }
+  stopping = false;
+  device_state = DeviceState::OPENING;
+  worker = std::thread(&SoundManager::worker_loop, this);
+
+  initialized = true;
+  return true;
+}
+
+// Worker thread: opens the mixer and loads every sound
+bool SoundManager::open_device() {
+  gint64 started = g_get_monotonic_time();
+
+  // Initialize SDL Audio
+  {
+    std::lock_guard<std::mutex> lock(sdl_subsystem_mutex);
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+      std::cout << "SDL Audio initialization failed: " << SDL_GetError()
+                << std::endl;
+      return false;
+    }
+  }
 
   // Initialize SDL_mixer with more channels for mixing
-  if (Mix_OpenAudio(22050, MIX_DEFAULT_FORMAT, 2, 1024) < 0) {
+  if (Mix_OpenAudio(sample_rate, MIX_DEFAULT_FORMAT, 2, buffer_frames) < 0) {
     std::cout << "SDL_mixer initialization failed: " << Mix_GetError()
               << std::endl;
-    SDL_Quit();
+    std::lock_guard<std::mutex> lock(sdl_subsystem_mutex);
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
     return false;
   }
+  int channels;
+  Uint16 format;
+  Mix_QuerySpec(&sample_rate, &format, &channels);
+  std::cout << "Audio mixer: " << sample_rate << " Hz, " << buffer_frames
+            << " frame buffer (" << buffer_frames * 1000.0 / sample_rate
+            << " ms)" << std::endl;
 
   // Allocate multiple channels for simultaneous playback and mixing
-  Mix_AllocateChannels(16); // Allow up to 16 sounds to mix together
+  Mix_AllocateChannels(MIXER_CHANNELS);
 
-  initialized = true;
-  std::cout << "SDL Audio initialized successfully with mixing support" << std::endl;
+  // Decode everything now so the first jump isn't late
+  if (mode == SoundMode::SYNTH) {
+    synthesize_sounds();
+  } else {
+    preload_sounds();
+  }
+  Mix_SetPostMix(&SoundManager::on_post_mix, this);
+
+  std::cout << "SDL Audio ready after "
+            << (g_get_monotonic_time() - started) / 1000 << " ms" << std::endl;
   return true;
 }
 
@@ -35,22 +156,58 @@ void SoundManager::cleanup() {
   if (!initialized)
     return;
 
-  std::lock_guard<std::mutex> lock(sound_mutex);
+  // Let the worker finish what it is doing; anything still queued is dropped
+  stopping = true;
+  SDL_SemPost(commands_waiting);
+  worker.join();
+  SDL_DestroySemaphore(commands_waiting);
+  commands_waiting = nullptr;
 
-  // Stop all playing sounds
-  Mix_HaltChannel(-1);
+  if (device_state == DeviceState::READY) {
+    // Stop all playing sounds
+    Mix_SetPostMix(nullptr, nullptr);
+    Mix_HaltChannel(-1);
 
-  // Free all cached sounds
-  for (auto &pair : sound_cache) {
-    if (pair.second) {
-      Mix_FreeChunk(pair.second);
+    // Free all cached sounds
+    for (auto &chunk : chunks) {
+      if (chunk) {
+        Mix_FreeChunk(chunk);
+        chunk = nullptr;
+      }
+    }
+    pcm_cache.reset(); // Only after the chunks that point into it are gone
+    for (auto &pcm : synth_pcm) {
+      pcm.clear();
     }
+
+    // Cleanup SDL_mixer and SDL audio; video may still be in use
+    Mix_CloseAudio();
+    std::lock_guard<std::mutex> lock(sdl_subsystem_mutex);
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
   }
-  sound_cache.clear();
 
-  // Cleanup SDL_mixer and SDL
-  Mix_CloseAudio();
-  SDL_Quit();
+  if (dropped > 0) {
+    std::cout << "Audio queue was full, dropped " << dropped << " sounds"
+              << std::endl;
+  }
+  if (too_late > 0) {
+    std::cout << "Skipped " << too_late
+              << " sounds that waited too long for the audio device"
+              << std::endl;
+  }
+  if (mix_latency_count > 0) {
+    std::cout << "Sound latency to mixer: "
+              << mix_latency_total / 1000.0 / mix_latency_count
+              << " ms average, " << mix_latency_worst / 1000.0
+              << " ms worst over " << mix_latency_count
+              << " sounds, then up to " << buffer_frames * 1000.0 / sample_rate
+              << " ms in the device buffer" << std::endl;
+  }
+  if (voices_stolen > 0 || voices_unavailable > 0) {
+    std::cout << "Mixer channels ran out: " << voices_stolen
+              << " sounds cut short, " << voices_unavailable << " not played"
+              << std::endl;
+  }
 
   initialized = false;
   std::cout << "SDL Audio cleaned up" << std::endl;
@@ -72,69 +229,295 @@ std::string SoundManager::find_sound_file(const std::string &filename) {
   return "";
 }
 
-void SoundManager::play_sound(const std::string &filename) {
-  if (!sound_enabled || !initialized) {
+void SoundManager::play_sound(SoundId id) {
+  if (!sound_enabled || !initialized ||
+      device_state == DeviceState::FAILED) {
     return;
   }
 
-  // Use a separate thread for sound loading/playing to avoid blocking
-  std::thread sound_thread([this, filename]() {
-    std::lock_guard<std::mutex> lock(sound_mutex);
+  gint64 now = g_get_monotonic_time();
+  if (batching) {
+    int index = static_cast<int>(id);
+    if (!(pending & (1u << index))) {
+      pending |= 1u << index;
+      requested_at[index] = now;
+    }
+  } else {
+    send(id, now);
+  }
+}
 
-    // Check if sound is already cached
-    auto it = sound_cache.find(filename);
-    Mix_Chunk *sound = nullptr;
+void SoundManager::begin_tick() {
+  batching = true;
+  pending = 0;
+}
 
-    if (it != sound_cache.end()) {
-      sound = it->second;
-    } else {
-      // Load the sound file
-      std::string sound_path = find_sound_file(filename);
-      if (!sound_path.empty()) {
-        sound = Mix_LoadWAV(sound_path.c_str());
-        if (sound) {
-          sound_cache[filename] = sound;
-          std::cout << "Loaded sound: " << filename << std::endl;
-        } else {
-          std::cout << "Failed to load sound " << filename << ": "
-                    << Mix_GetError() << std::endl;
-          return;
-        }
-      } else {
-        return;
+// Sends what the tick asked for, most important first, once each
+void SoundManager::end_tick() {
+  batching = false;
+  for (int priority = IMPORTANT_PRIORITY; priority >= 0; priority--) {
+    for (int i = 0; i < SOUND_COUNT; i++) {
+      if ((pending & (1u << i)) && sound_rules[i].priority == priority) {
+        send(static_cast<SoundId>(i), requested_at[i]);
       }
     }
+  }
+  pending = 0;
+}
+
+void SoundManager::send(SoundId id, gint64 requested) {
+  int index = static_cast<int>(id);
+  gint64 now = g_get_monotonic_time();
+  if (last_sent[index] != 0 &&
+      now - last_sent[index] < sound_rules[index].cooldown_ms * 1000) {
+    return;
+  }
+  last_sent[index] = now;
 
-    // Play the sound on any available channel - SDL_mixer will mix them automatically
-    if (sound) {
-      int channel = Mix_PlayChannel(-1, sound, 0);
-      if (channel == -1) {
-        std::cout << "Failed to play sound " << filename << ": "
-                  << Mix_GetError() << std::endl;
-      } 
+  if (!commands.push({id, requested})) {
+    dropped++;
+    return;
+  }
+  SDL_SemPost(commands_waiting);
+}
+
+void SoundManager::worker_loop() {
+  bool ready = open_device();
+  device_state = ready ? DeviceState::READY : DeviceState::FAILED;
+
+  while (SDL_SemWait(commands_waiting) == 0 && !stopping) {
+    Command command;
+    while (commands.pop(command)) {
+      if (!ready) {
+        continue; // No device; just keep the queue empty
+      }
+      // Mostly sounds queued while a slow device was opening
+      if (g_get_monotonic_time() - command.requested >
+          MAX_SOUND_DELAY_MS * 1000) {
+        too_late++;
+        continue;
+      }
+      play_now(command.id, command.requested);
     }
-  });
+  }
+}
+
+// Uses the PCM cache where it is up to date and decodes the rest, then
+// rewrites the cache if anything had to be decoded
+void SoundManager::preload_sounds() {
+  int rate, channels;
+  Uint16 format;
+  Mix_QuerySpec(&rate, &format, &channels);
+  pcm_cache = std::make_unique<SoundCache>(SoundCache::default_path(), rate,
+                                           format, channels);
+  bool have_cache = pcm_cache->open();
+
+  std::vector<std::pair<SoundCache::Source, const Mix_Chunk *>> cacheable;
+  int loaded = 0;
+  int from_cache = 0;
+  bool stale = false;
+  for (int i = 0; i < SOUND_COUNT; i++) {
+    std::string filename = sound_file_name(static_cast<SoundId>(i));
+    std::string sound_path = find_sound_file(filename);
+    // Without a file on disk, use the copy built into the game if there is one
+    const EmbeddedAsset *embedded =
+        sound_path.empty() ? find_embedded_asset("audio/" + filename) : nullptr;
+    if (sound_path.empty() && !embedded) {
+      continue;
+    }
+
+    SoundCache::Source source;
+    bool described = true;
+    if (embedded) {
+      SoundCache::describe(*embedded, filename, source);
+    } else {
+      described = SoundCache::describe(sound_path, filename, source);
+    }
+    uint32_t length = 0;
+    uint8_t *pcm = (described && have_cache) ? pcm_cache->find(source, length)
+                                             : nullptr;
+    if (pcm) {
+      chunks[i] = Mix_QuickLoad_RAW(pcm, length);
+      from_cache++;
+    } else if (embedded) {
+      chunks[i] = Mix_LoadWAV_RW(
+          SDL_RWFromConstMem(embedded->data, embedded->size), 1);
+      stale = true;
+    } else {
+      chunks[i] = Mix_LoadWAV(sound_path.c_str());
+      stale = true;
+    }
+    if (!chunks[i]) {
+      std::cout << "Failed to load sound " << filename << ": "
+                << Mix_GetError() << std::endl;
+      continue;
+    }
+    if (described) {
+      cacheable.push_back({source, chunks[i]});
+    }
+    loaded++;
+  }
+
+  if (stale && !cacheable.empty()) {
+    if (!pcm_cache->save(cacheable)) {
+      std::cout << "Warning: Could not write the sound cache" << std::endl;
+    }
+  }
+  std::cout << "Loaded " << loaded << " of " << SOUND_COUNT << " sounds ("
+            << from_cache << " from cache)" << std::endl;
+}
+
+// Makes every sound at the mixer's format; nothing is read from disk
+void SoundManager::synthesize_sounds() {
+  int rate, channels;
+  Uint16 format;
+  Mix_QuerySpec(&rate, &format, &channels);
+
+  int made = 0;
+  for (int i = 0; i < SOUND_COUNT; i++) {
+    if (!synthesize_sound(static_cast<SoundId>(i), rate, format, channels,
+                          synth_pcm[i])) {
+      std::cout << "Failed to synthesize sound "
+                << sound_name(static_cast<SoundId>(i)) << ": "
+                << SDL_GetError() << std::endl;
+      continue;
+    }
+    chunks[i] = Mix_QuickLoad_RAW(synth_pcm[i].data(), synth_pcm[i].size());
+    if (chunks[i]) {
+      made++;
+    }
+  }
+  std::cout << "Synthesized " << made << " of " << SOUND_COUNT << " sounds"
+            << std::endl;
+}
+
+// Worker thread: plays the sound on a free channel, or on one taken from a
+// less important sound
+void SoundManager::play_now(SoundId id, gint64 requested) {
+  Mix_Chunk *sound = chunks[static_cast<int>(id)];
+  if (!sound) {
+    return; // Missing or failed to load; already reported
+  }
+
+  int priority = sound_rules[static_cast<int>(id)].priority;
+  int channel = Mix_PlayChannel(-1, sound, 0);
+  if (channel == -1) {
+    channel = steal_voice(priority);
+    if (channel >= 0) {
+      channel = Mix_PlayChannel(channel, sound, 0);
+    }
+  }
+  if (channel < 0 || channel >= MIXER_CHANNELS) {
+    voices_unavailable++;
+    return;
+  }
+  voices[channel].priority = priority;
+  voices[channel].started = g_get_monotonic_time();
+  // If the mixer runs between starting the sound and this store, the
+  // sound is counted one buffer late; the window is a few instructions wide
+  awaiting_mix[channel] = requested;
+}
 
-  sound_thread.detach(); // Let the thread run independently
+// Mixer thread, after each buffer is mixed: every sound stamped since the
+// last buffer has now been picked up
+void SoundManager::on_post_mix(void *udata, Uint8 *, int) {
+  SoundManager *self = static_cast<SoundManager *>(udata);
+  gint64 now = g_get_monotonic_time();
+  for (auto &stamp : self->awaiting_mix) {
+    gint64 requested = stamp.exchange(0);
+    if (requested == 0) {
+      continue;
+    }
+    gint64 latency = now - requested;
+    self->mix_latency_total += latency;
+    self->mix_latency_worst = std::max(self->mix_latency_worst, latency);
+    self->mix_latency_count++;
+  }
+}
+
+// Halts and returns the least important, oldest channel this sound may take,
+// or -1 if everything playing matters more
+int SoundManager::steal_voice(int priority) {
+  int victim = -1;
+  for (int channel = 0; channel < MIXER_CHANNELS; channel++) {
+    if (!Mix_Playing(channel)) {
+      return channel; // Finished since the mixer said it was full
+    }
+    const Voice &voice = voices[channel];
+    bool allowed =
+        voice.priority < priority ||
+        (priority >= IMPORTANT_PRIORITY && voice.priority <= priority);
+    if (!allowed) {
+      continue;
+    }
+    if (victim < 0 || voice.priority < voices[victim].priority ||
+        (voice.priority == voices[victim].priority &&
+         voice.started < voices[victim].started)) {
+      victim = channel;
+    }
+  }
+
+  if (victim >= 0) {
+    Mix_HaltChannel(victim);
+    voices_stolen++;
+  }
+  return victim;
 }
 
 // Additional methods for mixer control
 void SoundManager::stop_all_sounds() {
-  if (initialized) {
+  if (device_state == DeviceState::READY) {
     Mix_HaltChannel(-1);
     std::cout << "All sounds stopped" << std::endl;
   }
 }
 
 int SoundManager::get_playing_channels() {
-  if (!initialized) return 0;
+  if (device_state != DeviceState::READY) return 0;
   return Mix_Playing(-1);
 }
 
 void SoundManager::set_master_volume(int volume) {
   // Volume should be 0-128 (SDL_mixer range)
-  if (initialized && volume >= 0 && volume <= 128) {
+  if (device_state == DeviceState::READY && volume >= 0 && volume <= 128) {
     Mix_Volume(-1, volume); // Set volume for all channels
     std::cout << "Master volume set to: " << volume << std::endl;
   }
 }
+
+// Recording
+
+RecordingAudio::RecordingAudio(const std::string &path) : path(path) {}
+
+bool RecordingAudio::initialize() {
+  out.open(path, std::ios::trunc);
+  if (!out) {
+    std::cout << "Could not open sound log " << path << std::endl;
+    return false;
+  }
+  std::cout << "Recording sounds to " << path << std::endl;
+  return true;
+}
+
+void RecordingAudio::cleanup() {
+  if (out.is_open()) {
+    out.close();
+  }
+}
+
+void RecordingAudio::play_sound(SoundId id) {
+  uint32_t bit = 1u << static_cast<int>(id);
+  if (!sound_enabled || !out.is_open() || (in_tick && (written & bit))) {
+    return;
+  }
+  written |= bit;
+  out << tick << " " << sound_name(id) << "\n";
+}
+
+void RecordingAudio::begin_tick() {
+  tick++;
+  in_tick = true;
+  written = 0;
+}
+
+void RecordingAudio::end_tick() { in_tick = false; }
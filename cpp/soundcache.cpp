@@ -0,0 +1,253 @@
+#include "willy.h"
+#include <cstring>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h> // For _mkdir
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// File layout: a Header, header.count Entries, then each sound's PCM at the
+// offset its entry gives. Everything is native-endian; the cache never leaves
+// the machine that wrote it.
+namespace {
+const char CACHE_MAGIC[8] = {'W', 'I', 'L', 'L', 'Y', 'P', 'C', 'M'};
+const uint32_t CACHE_VERSION = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  int32_t rate;
+  uint16_t format;
+  uint16_t channels;
+  uint32_t count;
+};
+
+struct Entry {
+  char name[32];
+  uint64_t size;
+  int64_t mtime;
+  uint64_t hash;
+  uint64_t offset;
+  uint32_t length;
+  uint32_t reserved;
+};
+
+const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+
+// FNV-1a; the sounds are small
+uint64_t hash_bytes(uint64_t hash, const uint8_t *bytes, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+void make_directory(const std::string &dir) {
+#ifdef _WIN32
+  _mkdir(dir.c_str());
+#else
+  mkdir(dir.c_str(), 0755);
+#endif
+}
+} // namespace
+
+SoundCache::SoundCache(const std::string &path, int rate, Uint16 format,
+                       int channels)
+    : path(path), rate(rate), format(format), channels(channels) {}
+
+SoundCache::~SoundCache() {
+#ifndef _WIN32
+  if (mapped) {
+    munmap(data, data_size);
+  }
+#endif
+}
+
+std::string SoundCache::default_path() {
+  const char *home = getenv("HOME");
+  if (!home) {
+    home = getenv("USERPROFILE"); // Windows fallback
+    if (!home) {
+      return "";
+    }
+  }
+
+  std::string willy_dir = std::string(home) + "/.willytheworm";
+  make_directory(willy_dir);
+  make_directory(willy_dir + "/cache");
+  return willy_dir + "/cache/sounds.pcm";
+}
+
+bool SoundCache::describe(const std::string &file_path,
+                          const std::string &name, Source &source) {
+  struct stat file_stat;
+  if (stat(file_path.c_str(), &file_stat) != 0) {
+    return false;
+  }
+  std::ifstream file(file_path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  uint64_t hash = FNV_OFFSET;
+  char buffer[8192];
+  while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+    hash = hash_bytes(hash, reinterpret_cast<const uint8_t *>(buffer),
+                      file.gcount());
+  }
+
+  source.name = name;
+  source.size = file_stat.st_size;
+  source.mtime = file_stat.st_mtime;
+  source.hash = hash;
+  return true;
+}
+
+void SoundCache::describe(const EmbeddedAsset &asset, const std::string &name,
+                          Source &source) {
+  source.name = name;
+  source.size = asset.size;
+  source.mtime = 0; // Only ever changes along with the executable
+  source.hash = hash_bytes(FNV_OFFSET, asset.data, asset.size);
+}
+
+bool SoundCache::open() {
+  if (path.empty() || data) {
+    return false;
+  }
+
+#ifdef _WIN32
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  contents.assign(std::istreambuf_iterator<char>(file),
+                  std::istreambuf_iterator<char>());
+  data = contents.data();
+  data_size = contents.size();
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+  // Private and writable so nothing the mixer does can reach the file
+  void *mapping = mmap(nullptr, file_stat.st_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  data = static_cast<uint8_t *>(mapping);
+  data_size = file_stat.st_size;
+  mapped = true;
+#endif
+
+  Header header;
+  if (data_size < sizeof(header)) {
+    return false;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+      header.version != CACHE_VERSION || header.rate != rate ||
+      header.format != format || header.channels != channels ||
+      data_size < sizeof(Header) + (uint64_t)header.count * sizeof(Entry)) {
+    return false;
+  }
+  return true;
+}
+
+uint8_t *SoundCache::find(const Source &source, uint32_t &length) const {
+  if (!data) {
+    return nullptr;
+  }
+
+  Header header;
+  memcpy(&header, data, sizeof(header));
+  for (uint32_t i = 0; i < header.count; i++) {
+    Entry entry;
+    memcpy(&entry, data + sizeof(Header) + i * sizeof(Entry), sizeof(entry));
+    if (strncmp(entry.name, source.name.c_str(), sizeof(entry.name)) != 0) {
+      continue;
+    }
+    if (entry.size != source.size || entry.mtime != source.mtime ||
+        entry.hash != source.hash || entry.offset > data_size ||
+        entry.length > data_size - entry.offset) {
+      return nullptr; // The source changed since it was cached
+    }
+    length = entry.length;
+    return data + entry.offset;
+  }
+  return nullptr;
+}
+
+bool SoundCache::save(
+    const std::vector<std::pair<Source, const Mix_Chunk *>> &sounds) const {
+  if (path.empty()) {
+    return false;
+  }
+
+  Header header = {};
+  memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.version = CACHE_VERSION;
+  header.rate = rate;
+  header.format = format;
+  header.channels = channels;
+  header.count = sounds.size();
+
+  // PCM starts after the table, each sound on a 16-byte boundary
+  std::vector<Entry> entries;
+  uint64_t offset = sizeof(Header) + sounds.size() * sizeof(Entry);
+  for (const auto &sound : sounds) {
+    Entry entry = {};
+    strncpy(entry.name, sound.first.name.c_str(), sizeof(entry.name) - 1);
+    entry.size = sound.first.size;
+    entry.mtime = sound.first.mtime;
+    entry.hash = sound.first.hash;
+    offset = (offset + 15) & ~(uint64_t)15;
+    entry.offset = offset;
+    entry.length = sound.second->alen;
+    offset += entry.length;
+    entries.push_back(entry);
+  }
+
+  // Write a temporary file and rename it, so a crash never leaves a half
+  // written cache and a mapped old one stays intact
+  std::string temp_path = path + ".tmp";
+  std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    return false;
+  }
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(entries.data()),
+             entries.size() * sizeof(Entry));
+  for (size_t i = 0; i < sounds.size(); i++) {
+    static const char padding[16] = {};
+    file.write(padding, (std::streamoff)entries[i].offset -
+                            (std::streamoff)file.tellp());
+    file.write(reinterpret_cast<const char *>(sounds[i].second->abuf),
+               entries[i].length);
+  }
+  file.close();
+  if (!file) {
+    std::remove(temp_path.c_str());
+    return false;
+  }
+
+#ifdef _WIN32
+  std::remove(path.c_str()); // rename() won't replace a file on Windows
+#endif
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
@@ -3,11 +3,8 @@
 #include <getopt.h>
 #include <unistd.h>
 
-extern double redbg;
-extern double greenbg;
-extern double bluebg;
-
-SpriteLoader::SpriteLoader(int scale) : scale_factor(scale) {
+SpriteLoader::SpriteLoader(int scale, SpriteFilter filter)
+    : scale_factor(scale), filter(filter) {
   // Initialize sprite name mapping
   named_parts["0"] = "WILLY_RIGHT";
   named_parts["1"] = "WILLY_LEFT";
@@ -53,6 +50,11 @@ void SpriteLoader::load_sprites() {
     } catch (const std::exception &e) {
       std::cout << "Error loading .chr file: " << e.what() << std::endl;
     }
+  } else if (const EmbeddedAsset *embedded = find_embedded_asset("willy.chr")) {
+    load_old_format(std::vector<uint8_t>(embedded->data,
+                                         embedded->data + embedded->size));
+    std::cout << "Loaded built-in sprites" << std::endl;
+    return;
   }
 
   std::cout << "Creating fallback sprites..." << std::endl;
@@ -79,12 +81,39 @@ void SpriteLoader::load_chr_file(const std::string &path) {
 void SpriteLoader::load_old_format(const std::vector<uint8_t> &data) {
   int num_chars = data.size() / 8;
 
+  // Filter the whole glyph set in one go so the per-sprite work below is just
+  // a copy into the surface
+  std::vector<uint32_t> masks;
+  auto start = std::chrono::steady_clock::now();
+  hqx_scale_glyphs(data.data(), num_chars, filter, masks);
+  auto elapsed = std::chrono::duration<double, std::micro>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  mask_size = 8 * sprite_filter_factor(filter);
+
+  if (filter != SpriteFilter::NEAREST) {
+    std::cout << "Filtered " << num_chars << " glyphs with "
+              << sprite_filter_name(filter) << " ("
+              << simd_level_name(detect_simd_level()) << ") in " << elapsed
+              << " us" << std::endl;
+    if ((GAME_CHAR_WIDTH * scale_factor) % mask_size != 0) {
+      std::cout << "Note: " << sprite_filter_name(filter)
+                << " sprites are smoothed to fit scale " << scale_factor
+                << "; a scale that's a multiple of "
+                << sprite_filter_factor(filter) << " keeps them sharp"
+                << std::endl;
+    }
+  }
+
   for (int i = 0; i < num_chars; i++) {
     auto it = named_parts.find(std::to_string(i));
     if (it != named_parts.end()) {
       try {
-        auto surface = create_sprite_from_bitmap(data, i);
+        auto surface =
+            create_sprite_from_mask(&masks[i * mask_size], mask_size);
         sprites[it->second] = surface;
+        glyph_masks[it->second].assign(masks.begin() + i * mask_size,
+                                       masks.begin() + (i + 1) * mask_size);
       } catch (const std::exception &e) {
         std::cout << "Error creating sprite " << i << ": " << e.what()
                   << std::endl;
@@ -96,30 +125,51 @@ void SpriteLoader::load_old_format(const std::vector<uint8_t> &data) {
 Cairo::RefPtr<Cairo::ImageSurface>
 SpriteLoader::create_sprite_from_bitmap(const std::vector<uint8_t> &data,
                                         int char_index) {
+  uint32_t rows[8];
+  for (int row = 0; row < 8; row++) {
+    rows[row] = data[char_index * 8 + row];
+  }
+  return create_sprite_from_mask(rows, 8);
+}
 
+Cairo::RefPtr<Cairo::ImageSurface>
+SpriteLoader::create_sprite_from_mask(const uint32_t *rows, int mask_size) {
   int size = GAME_CHAR_WIDTH * scale_factor;
-  auto surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, size, size);
-  auto ctx = Cairo::Context::create(surface);
-
-  // Clear to transparent
-  ctx->set_operator(Cairo::OPERATOR_CLEAR);
-  ctx->paint();
-  ctx->set_operator(Cairo::OPERATOR_OVER);
 
-  // Extract bits and draw pixels
-  for (int row = 0; row < 8; row++) {
-    uint8_t byte = data[char_index * 8 + row];
-    for (int col = 0; col < 8; col++) {
-      int bit = (byte >> (7 - col)) & 1;
-      if (bit) {
-        ctx->set_source_rgba(1.0, 1.0, 1.0, 1.0); // White pixel
-        ctx->rectangle(col * scale_factor, row * scale_factor, scale_factor,
-                       scale_factor);
-        ctx->fill();
-      }
+  // Each mask pixel becomes a whole block of step x step pixels: white where
+  // the mask is set, transparent elsewhere. When the sprite size isn't a
+  // multiple of the mask (hq2x at -S 3, hq4x below -S 4) the blocks are built
+  // for the next multiple up and Cairo shrinks the result smoothly, rather
+  // than doubling or dropping odd rows and columns.
+  int step = (size + mask_size - 1) / mask_size;
+  int blocks_size = mask_size * step;
+  auto blocks = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, blocks_size,
+                                            blocks_size);
+  blocks->flush();
+  unsigned char *pixels = blocks->get_data();
+  int stride = blocks->get_stride();
+
+  for (int y = 0; y < blocks_size; y++) {
+    uint32_t bits = rows[y / step];
+    uint32_t *dst = reinterpret_cast<uint32_t *>(pixels + y * stride);
+    for (int x = 0; x < blocks_size; x++) {
+      int bit = (bits >> (mask_size - 1 - x / step)) & 1;
+      dst[x] = bit ? 0xFFFFFFFFu : 0x00000000u;
     }
   }
+  blocks->mark_dirty();
+
+  if (blocks_size == size) {
+    return blocks;
+  }
 
+  auto surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, size, size);
+  auto ctx = Cairo::Context::create(surface);
+  ctx->scale((double)size / blocks_size, (double)size / blocks_size);
+  auto pattern = Cairo::SurfacePattern::create(blocks);
+  pattern->set_filter(Cairo::FILTER_GOOD);
+  ctx->set_source(pattern);
+  ctx->paint();
   return surface;
 }
 
@@ -271,8 +321,12 @@ SpriteLoader::create_spring_sprite(bool upward) {
       ctx->fill();
     }
   } else {
-    ctx->set_source_rgb(redbg, greenbg, bluebg); // Blue
-    // Vertical lines (coil effect)
+    ctx->set_source_rgb(0.0, 1.0, 0.0); // Green
+    ctx->rectangle(0, size * 0.25, size, size * 0.5);
+    ctx->fill();
+    // Vertical gaps (coil effect) are cut out so whatever background the
+    // sprite is painted on shows through
+    ctx->set_operator(Cairo::OPERATOR_CLEAR);
     int line_width = std::max(1, size / 8);
     for (int i = 0; i < 4; i++) {
       int x = i * (size / 4);
@@ -297,3 +351,11 @@ SpriteLoader::get_sprite(const std::string &name) {
   }
   return sprites["EMPTY"];
 }
+
+const uint32_t *SpriteLoader::get_mask(const std::string &name) const {
+  auto it = glyph_masks.find(name);
+  if (it != glyph_masks.end()) {
+    return it->second.data();
+  }
+  return nullptr;
+}
@@ -0,0 +1,111 @@
+#include "willy.h"
+
+extern GameOptions game_options;
+extern double redbg;
+extern double greenbg;
+extern double bluebg;
+
+// Parsing the levels, building the sprites and reading the high scores don't
+// touch GTK or each other, so each runs on its own thread while the window
+// shows a splash. The game needs the levels and sprites before it can take
+// input; the high scores only matter once a game ends, and HighScoreManager
+// locks, so they are left to finish whenever they do.
+
+void WillyGame::start_loading() {
+  loading = true;
+  loading_started = g_get_monotonic_time();
+  loading_progress.connect(
+      sigc::mem_fun(*this, &WillyGame::on_loading_progress));
+
+  std::string levels_file = game_options.levels_file;
+  levels_loading = std::async(std::launch::async, [this, levels_file]() {
+    auto loader = std::make_unique<LevelLoader>();
+    if (!loader->load_levels(levels_file)) {
+      std::cout << "Warning: Failed to load " << levels_file
+                << ", trying default levels.json" << std::endl;
+      loader->load_levels("levels.json");
+    }
+    loading_tasks_done++;
+    loading_progress.emit();
+    return loader;
+  });
+
+  int scale = scale_factor;
+  SpriteFilter filter = game_options.sprite_filter;
+  sprites_loading = std::async(std::launch::async, [this, scale, filter]() {
+    auto loader = std::make_unique<SpriteLoader>(scale, filter);
+    loading_tasks_done++;
+    loading_progress.emit();
+    return loader;
+  });
+
+  // The manager exists from the start with empty tables; only the file is
+  // read in the background
+  score_manager = std::make_unique<HighScoreManager>();
+  HighScoreManager *scores = score_manager.get();
+  scores_loading = std::async(std::launch::async,
+                              [scores]() { scores->load_scores(); });
+}
+
+// Blocks until the game can start; for runs that have no splash to show
+void WillyGame::wait_for_loading() {
+  levels_loading.wait();
+  sprites_loading.wait();
+  finish_loading();
+}
+
+// GTK thread, each time a loading task finishes. The task emits just before
+// it returns, so its future may not be ready yet; finish_loading() waits the
+// moment that takes.
+void WillyGame::on_loading_progress() {
+  if (!loading || quitting) {
+    return;
+  }
+  if (loading_tasks_done == 2) {
+    finish_loading();
+    wake();
+  }
+}
+
+void WillyGame::finish_loading() {
+  level_loader = levels_loading.get();
+  sprite_loader = sprites_loading.get();
+  loading = false;
+  std::cout << "Ready to play after "
+            << (g_get_monotonic_time() - loading_started) / 1000 << " ms"
+            << std::endl;
+
+  // Nobody is there to press Enter on a headless run, so go straight in
+  if (game_options.backend == RenderBackend::HEADLESS) {
+    start_game();
+  }
+
+  // Game logic on its own thread; headless runs step it themselves so they
+  // stay deterministic
+  if (game_options.sim_thread) {
+    if (game_options.backend == RenderBackend::HEADLESS) {
+      std::cout << "Note: --sim-thread is ignored for headless runs"
+                << std::endl;
+    } else {
+      start_sim_thread();
+    }
+  }
+}
+
+void WillyGame::draw_splash_screen(const Cairo::RefPtr<Cairo::Context> &cr) {
+  int width, height;
+  get_render_size(width, height);
+
+  cr->set_source_rgb(redbg, greenbg, bluebg);
+  cr->paint();
+
+  BitmapFont &font = get_font("Courier", 24);
+  std::string title = "Willy the Worm";
+  std::string status = "Loading...";
+  int line = font.get_cell_height();
+  int y = viewport.menubar_height + (height - viewport.menubar_height) / 2;
+  font.draw_text(cr, (width - font.measure(title)) / 2, y - 2 * line, title,
+                 1.0, 1.0, 1.0);
+  font.draw_text(cr, (width - font.measure(status)) / 2, y + line, status, 1.0,
+                 1.0, 1.0);
+}
@@ -0,0 +1,90 @@
+#include "willy.h"
+#include <cstring>
+
+// The 1985 original beeped through the PC speaker. These are square-wave
+// tunes in that spirit, rendered once at startup in the mixer's format, so a
+// build without MP3 support or the audio/ files still has sound.
+
+namespace {
+struct Tone {
+  int frequency; // Hz, 0 for silence
+  int ms;
+};
+
+const int SYNTH_AMPLITUDE = 6000; // Out of 32767; square waves are loud
+
+std::vector<Tone> sound_tones(SoundId id) {
+  std::vector<Tone> tones;
+  switch (id) {
+  case SoundId::BELL: // Level finished: a rising arpeggio
+    tones = {{523, 70}, {659, 70}, {784, 70}, {1047, 140}};
+    break;
+  case SoundId::BOOP: // Jumped a ball
+    tones = {{330, 45}};
+    break;
+  case SoundId::JUMP: // Quick upward sweep
+    for (int step = 0; step < 8; step++) {
+      tones.push_back({400 + step * 80, 15});
+    }
+    break;
+  case SoundId::LADDER: // One click per rung
+    tones = {{1200, 12}};
+    break;
+  case SoundId::PRESENT:
+    tones = {{880, 50}, {0, 20}, {1320, 80}};
+    break;
+  case SoundId::TACK: // Falling sweep
+    for (int step = 0; step < 12; step++) {
+      tones.push_back({800 - step * 55, 25});
+    }
+    break;
+  default:
+    break;
+  }
+  return tones;
+}
+} // namespace
+
+// Renders the sound as signed 16-bit mono at rate, then converts it to the
+// given format and channel count. Returns false if SDL can't convert.
+bool synthesize_sound(SoundId id, int rate, Uint16 format, int channels,
+                      std::vector<Uint8> &pcm) {
+  std::vector<Sint16> samples;
+  double phase = 0.0; // Carried across tones so a change of pitch doesn't click
+  for (const Tone &tone : sound_tones(id)) {
+    int count = rate * tone.ms / 1000;
+    for (int i = 0; i < count; i++) {
+      if (tone.frequency == 0) {
+        samples.push_back(0);
+        continue;
+      }
+      samples.push_back(phase < 0.5 ? SYNTH_AMPLITUDE : -SYNTH_AMPLITUDE);
+      phase += (double)tone.frequency / rate;
+      phase -= std::floor(phase);
+    }
+  }
+  if (samples.empty()) {
+    return false;
+  }
+
+  SDL_AudioCVT cvt;
+  int needed = SDL_BuildAudioCVT(&cvt, AUDIO_S16SYS, 1, rate, format,
+                                 channels, rate);
+  if (needed < 0) {
+    return false;
+  }
+  int bytes = samples.size() * sizeof(Sint16);
+  pcm.assign((size_t)bytes * std::max(1, cvt.len_mult), 0);
+  std::memcpy(pcm.data(), samples.data(), bytes);
+  if (needed > 0) {
+    cvt.buf = pcm.data();
+    cvt.len = bytes;
+    if (SDL_ConvertAudio(&cvt) < 0) {
+      return false;
+    }
+    pcm.resize(cvt.len_cvt);
+  } else {
+    pcm.resize(bytes);
+  }
+  return true;
+}
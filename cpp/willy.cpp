@@ -9,12 +9,13 @@ double bluebg = 1.0;
 GameOptions game_options;
 
 // Ball implementation
-Ball::Ball(int r, int c) : row(r), col(c), direction("") {}
+Ball::Ball(int r, int c)
+    : row(r), col(c), prev_row(r), prev_col(c), direction("") {}
 
 // Replace the window decoration section in the WillyGame constructor with this:
 
 WillyGame::WillyGame()
-    : vbox(Gtk::ORIENTATION_VERTICAL), current_state(GameState::INTRO),
+    : current_state(GameState::INTRO),
       scale_factor(game_options.scale_factor), 
       level(game_options.starting_level), 
       score(0), lives(5), bonus(1000), willy_position({23, 7}),
@@ -26,36 +27,54 @@ WillyGame::WillyGame()
       mouse_direction(""), mouse_up_held(false), mouse_down_held(false),
       up_pressed(false), down_pressed(false), life_adder(0), gen(rd()) {
 
-  // Set title and window properties FIRST
-  set_title("Willy the Worm - C++ GTK Edition");
-  
-  // Force window decorations and properties
-  set_decorated(true);
-  set_deletable(true);  
-  set_resizable(true);
-  set_skip_taskbar_hint(false);
-  set_skip_pager_hint(false);
-  set_type_hint(Gdk::WINDOW_TYPE_HINT_NORMAL);
-  property_window_position().set_value(Gtk::WIN_POS_CENTER);
-  
-  // Force the window to be realized immediately so we can set native decorations
-  realize();
-  
-  // Now that window is realized, we can access the native window
-  auto window = get_window();
-  if (window) {
-    window->set_decorations(Gdk::DECOR_ALL);
-    window->set_functions(Gdk::FUNC_ALL);
-    window->set_type_hint(Gdk::WINDOW_TYPE_HINT_NORMAL);
-  }
-
-  // Initialize managers
-  score_manager = std::make_unique<HighScoreManager>();
-  sprite_loader = std::make_unique<SpriteLoader>(scale_factor);
-  level_loader = std::make_unique<LevelLoader>();
-  sound_manager = std::make_unique<SoundManager>();
-  
-  // Initialize sound system
+  // Headless runs draw into memory only, so they create no widgets at all
+  // and need no display
+  if (game_options.backend != RenderBackend::HEADLESS) {
+    game_window = std::make_unique<GameWindow>();
+    game_window->on_paint = [this](const Cairo::RefPtr<Cairo::Context> &cr) {
+      return on_draw(cr);
+    };
+    game_window->on_hidden = [this]() { on_window_hidden(); };
+
+    // Set title and window properties FIRST
+    game_window->set_title("Willy the Worm - C++ GTK Edition");
+
+    // Force window decorations and properties
+    game_window->set_decorated(true);
+    game_window->set_deletable(true);
+    game_window->set_resizable(true);
+    game_window->set_skip_taskbar_hint(false);
+    game_window->set_skip_pager_hint(false);
+    game_window->set_type_hint(Gdk::WINDOW_TYPE_HINT_NORMAL);
+    game_window->property_window_position().set_value(Gtk::WIN_POS_CENTER);
+
+    // Force the window to be realized immediately so we can set native
+    // decorations
+    game_window->realize();
+
+    // Now that window is realized, we can access the native window
+    auto window = game_window->get_window();
+    if (window) {
+      window->set_decorations(Gdk::DECOR_ALL);
+      window->set_functions(Gdk::FUNC_ALL);
+      window->set_type_hint(Gdk::WINDOW_TYPE_HINT_NORMAL);
+    }
+  }
+
+  // Pick where sounds go
+  if (game_options.sound_mode == SoundMode::NONE) {
+    sound_manager = std::make_unique<NullAudio>();
+  } else if (game_options.sound_mode == SoundMode::RECORD) {
+    sound_manager =
+        std::make_unique<RecordingAudio>(game_options.sound_record_file);
+  } else {
+    sound_manager = std::make_unique<SoundManager>(game_options.sound_mode,
+                                                   game_options.audio_rate,
+                                                   game_options.audio_buffer);
+  }
+
+  // Sound comes first: the mixer backend opens the device on its own thread,
+  // so a slow sound server overlaps the loading below instead of delaying it
   if (!sound_manager->initialize()) {
     std::cout << "Warning: Sound system initialization failed" << std::endl;
   }
@@ -63,48 +82,123 @@ WillyGame::WillyGame()
   // Apply command line sound setting
   sound_manager->set_sound_enabled(game_options.sound_enabled);
 
-  // Load levels file from command line option
-  if (!level_loader->load_levels(game_options.levels_file)) {
-    std::cout << "Warning: Failed to load " << game_options.levels_file
-              << ", trying default levels.json" << std::endl;
-    level_loader->load_levels("levels.json");
-  }
+  // Levels, sprites and high scores load in the background from here on
+  start_loading();
 
   // Setup UI
-  setup_ui();
+  if (game_window) {
+    setup_ui();
+    game_window->show_all_children();
+  }
   current_state = GameState::INTRO;
-  
-  // Set up timer with command line FPS
-  timer_connection = Glib::signal_timeout().connect(
-      sigc::mem_fun(*this, &WillyGame::game_tick), 1000 / fps);
-
-  show_all_children();
 
   // Store base game dimensions (before any scaling)
   base_game_width = GAME_SCREEN_WIDTH * GAME_CHAR_WIDTH * scale_factor;
   base_game_height = (GAME_SCREEN_HEIGHT + 2) * GAME_CHAR_HEIGHT * scale_factor;
 
-  // Calculate proper window size
-  Gtk::Requisition menubar_min, menubar_nat;
-  menubar.get_preferred_size(menubar_min, menubar_nat);
-
-  Gtk::Requisition statusbar_min, statusbar_nat;
-  status_bar.get_preferred_size(statusbar_min, statusbar_nat);
+  // Pick where frames go
+  if (game_options.backend == RenderBackend::SDL) {
+    renderer = std::make_unique<SdlRenderer>(base_game_width, base_game_height);
+  } else if (game_options.backend == RenderBackend::HEADLESS) {
+    renderer =
+        std::make_unique<OffscreenRenderer>(base_game_width, base_game_height);
+  }
+  if (renderer && !renderer->initialize()) {
+    std::cout << "Warning: " << renderer->get_name()
+              << " renderer failed to initialize, using GTK" << std::endl;
+    renderer.reset();
+    game_options.backend = RenderBackend::GTK;
+  }
+  if (!renderer) {
+    renderer = std::make_unique<GtkRenderer>(*game_window,
+                                             game_window->drawing_area);
+  }
+  renderer->set_frame_drawer(sigc::mem_fun(*this, &WillyGame::render_frame));
+
+  // Frame capture reads from an offscreen surface; the GTK path has none, so
+  // it gets a second, capture-only target
+  if (!game_options.capture_dir.empty() ||
+      !game_options.export_video.empty()) {
+    frame_capture = std::make_unique<FrameCapture>(
+        game_options.capture_dir, game_options.capture_every,
+        game_options.capture_format, game_options.export_video, fps);
+    if (!frame_capture->start()) {
+      frame_capture.reset();
+    } else if (!renderer->get_frame()) {
+      capture_target = std::make_unique<OffscreenRenderer>(base_game_width,
+                                                           base_game_height);
+      capture_target->set_frame_drawer(
+          sigc::mem_fun(*this, &WillyGame::render_frame));
+      Viewport &capture = capture_state.viewport;
+      capture.target_width = base_game_width;
+      capture.target_height = base_game_height;
+      capture.cell_width = GAME_CHAR_WIDTH * scale_factor;
+      capture.cell_height = GAME_CHAR_HEIGHT * scale_factor;
+    }
+  }
+  renderer->set_key_handlers(sigc::mem_fun(*this, &WillyGame::on_key_press),
+                             sigc::mem_fun(*this, &WillyGame::on_key_release));
+  renderer->set_activity_handler(
+      sigc::mem_fun(*this, &WillyGame::set_window_active));
+
+  if (game_window) {
+    // Pause and stop ticking when the window is minimised or loses focus
+    game_window->signal_focus_in_event().connect(
+        sigc::mem_fun(*this, &WillyGame::on_focus_change));
+    game_window->signal_focus_out_event().connect(
+        sigc::mem_fun(*this, &WillyGame::on_focus_change));
+    game_window->signal_window_state_event().connect(
+        sigc::mem_fun(*this, &WillyGame::on_window_state_change));
+
+    // Calculate proper window size
+    Gtk::Requisition menubar_min, menubar_nat;
+    game_window->menubar.get_preferred_size(menubar_min, menubar_nat);
+
+    Gtk::Requisition statusbar_min, statusbar_nat;
+    game_window->status_bar.get_preferred_size(statusbar_min, statusbar_nat);
+
+    int total_height =
+        base_game_height + menubar_min.height + statusbar_min.height + 10;
+
+    game_window->set_default_size(base_game_width, total_height);
+    game_window->resize(base_game_width, total_height);
+
+    // Connect resize signal
+    game_window->signal_size_allocate().connect(
+        sigc::hide(sigc::mem_fun(*this, &WillyGame::on_window_resize)));
+  }
 
-  int total_height =
-      base_game_height + menubar_min.height + statusbar_min.height + 10;
+  // Initial scaling calculation
+  update_viewport();
 
-  set_default_size(base_game_width, total_height);
-  resize(base_game_width, total_height);
+  if (game_window) {
+    game_window->drawing_area.grab_focus();
+  }
 
-  // Connect resize signal
-  signal_size_allocate().connect(
-      sigc::hide(sigc::mem_fun(*this, &WillyGame::on_window_resize)));
+  // A headless run has nothing to show meanwhile, and its frames should be
+  // the same every time, so it waits here
+  if (game_options.backend == RenderBackend::HEADLESS) {
+    wait_for_loading();
+  }
 
-  // Initial scaling calculation
-  calculate_scaling_factors();
+  // Gamepads work alongside the keyboard; headless runs have no player
+  if (game_options.gamepad &&
+      game_options.backend != RenderBackend::HEADLESS) {
+    std::vector<GamepadInput::Binding> bindings =
+        GamepadInput::default_bindings();
+    GamepadInput::parse_bindings(game_options.gamepad_bindings, bindings);
+    gamepad = std::make_unique<GamepadInput>(bindings,
+                                             game_options.gamepad_deadzone);
+    gamepad_ready.connect(
+        sigc::mem_fun(*this, &WillyGame::on_gamepad_input));
+    if (!gamepad->start([this]() { gamepad_ready.emit(); })) {
+      gamepad.reset();
+    }
+  }
 
-  drawing_area.grab_focus();
+  // Set up timer with command line FPS if the first screen needs one
+  refresh_view();
+  update_tick_timer();
 
   // Print command line options being used
   std::cout << "Game initialized with options:" << std::endl;
@@ -114,17 +208,31 @@ WillyGame::WillyGame()
             << std::endl;
   std::cout << "  FPS: " << fps << std::endl;
   std::cout << "  Scale factor: " << scale_factor << std::endl;
+  std::cout << "  Sprite filter: "
+            << sprite_filter_name(game_options.sprite_filter) << std::endl;
+  std::cout << "  Renderer: " << renderer->get_name() << std::endl;
   std::cout << "  Sound enabled: "
             << (sound_manager->is_sound_enabled() ? "Yes" : "No") << std::endl;
+  std::cout << "  Sound effects: " << sound_mode_name(game_options.sound_mode)
+            << std::endl;
   if (game_options.use_wasd)
     std::cout << "  WASD controls: Enabled" << std::endl;
   if (game_options.disable_flash)
     std::cout << "  Death flash: Disabled" << std::endl;
   if (game_options.mouse_support)
     std::cout << "  Mouse support: Enabled" << std::endl;
+  if (sim_thread.joinable())
+    std::cout << "  Simulation thread: Enabled" << std::endl;
+  if (gamepad)
+    std::cout << "  Gamepad support: Enabled" << std::endl;
 }
 
-WillyGame::~WillyGame() { timer_connection.disconnect(); }
+WillyGame::~WillyGame() {
+  stop_tick_timer();
+  if (frame_capture) {
+    frame_capture->finish();
+  }
+}
 
 bool WillyGame::check_movement_collision(int old_row, int old_col, int new_row,
                                          int new_col) {
@@ -170,6 +278,7 @@ void WillyGame::start_game() {
   moving_continuously = false;
   up_pressed = false;
   down_pressed = false;
+  keys_tapped.clear();
   life_adder = 0;
 
   // Check if the specified starting level exists, fall back to level 1 if not
@@ -182,7 +291,6 @@ void WillyGame::start_game() {
   }
 
   load_level(level_name);
-  update_status_bar();
 }
 
 void WillyGame::jump() {
@@ -201,7 +309,7 @@ void WillyGame::jump() {
     // Apply a stronger jump if standing on "UPSPRING"
     willy_velocity.second = (current_tile == "UPSPRING") ? -6 : -5;
 
-    sound_manager->play_sound("jump.mp3");
+    sound_manager->play_sound(SoundId::JUMP);
   }
 }
 
@@ -211,6 +319,7 @@ std::string WillyGame::get_tile(int row, int col) {
 
 void WillyGame::set_tile(int row, int col, const std::string &tile) {
   level_loader->set_tile(current_level, row, col, tile);
+  grid_version++;
 }
 
 bool WillyGame::can_move_to(int row, int col) {
@@ -257,7 +366,13 @@ void WillyGame::update_willy_movement() {
   bool on_ladder = (current_tile == "LADDER");
   bool moved_on_ladder = false;
 
-  if (up_pressed) {
+  bool use_wasd = game_options.use_wasd;
+  bool up = up_pressed || key_down(GDK_KEY_Up) ||
+            (use_wasd && key_down(GDK_KEY_w));
+  bool down = down_pressed || key_down(GDK_KEY_Down) ||
+              (use_wasd && key_down(GDK_KEY_s));
+
+  if (up) {
     int target_row = willy_position.first - 1;
     if (target_row >= 0) {
       std::string above_tile = get_tile(target_row, willy_position.second);
@@ -272,7 +387,7 @@ void WillyGame::update_willy_movement() {
           moved_on_ladder = true;
           moving_continuously = false;
           continuous_direction = "";
-          sound_manager->play_sound("ladder.mp3"); // Add ladder sound
+          sound_manager->play_sound(SoundId::LADDER); // Add ladder sound
         } else {
           die();
           return;
@@ -287,7 +402,7 @@ void WillyGame::update_willy_movement() {
           moved_on_ladder = true;
           moving_continuously = false;
           continuous_direction = "";
-          sound_manager->play_sound("ladder.mp3"); // Add ladder sound
+          sound_manager->play_sound(SoundId::LADDER); // Add ladder sound
         } else {
           die();
           return;
@@ -296,7 +411,7 @@ void WillyGame::update_willy_movement() {
     }
   }
 
-  if (down_pressed && !moved_on_ladder) {
+  if (down && !moved_on_ladder) {
     int target_row = willy_position.first + 1;
     if (target_row < GAME_SCREEN_HEIGHT) {
       std::string below_tile = get_tile(target_row, willy_position.second);
@@ -310,7 +425,7 @@ void WillyGame::update_willy_movement() {
           moved_on_ladder = true;
           moving_continuously = false;
           continuous_direction = "";
-          sound_manager->play_sound("ladder.mp3"); // Add ladder sound
+          sound_manager->play_sound(SoundId::LADDER); // Add ladder sound
         } else {
           die();
           return;
@@ -325,7 +440,7 @@ void WillyGame::update_willy_movement() {
           moved_on_ladder = true;
           moving_continuously = false;
           continuous_direction = "";
-          sound_manager->play_sound("ladder.mp3"); // Add ladder sound
+          sound_manager->play_sound(SoundId::LADDER); // Add ladder sound
         } else {
           die();
           return;
@@ -371,7 +486,7 @@ void WillyGame::update_willy_movement() {
         continuous_direction = "";
       }
     } else if (!moving_continuously) {
-      if (keys_pressed.count("Left")) {
+      if (key_down(GDK_KEY_Left)) {
         willy_direction = "LEFT";
         if (can_move_to(willy_position.first, willy_position.second - 1)) {
           // Check for collision before moving
@@ -383,7 +498,7 @@ void WillyGame::update_willy_movement() {
             return;
           }
         }
-      } else if (keys_pressed.count("Right")) {
+      } else if (key_down(GDK_KEY_Right)) {
         willy_direction = "RIGHT";
         if (can_move_to(willy_position.first, willy_position.second + 1)) {
           // Check for collision before moving
@@ -527,7 +642,7 @@ void WillyGame::check_collisions() {
         set_tile(prev_y + 1, prev_x, "EMPTY");
 
         // Optional: Play a destruction sound
-        sound_manager->play_sound("present.mp3"); // Using existing sound
+        sound_manager->play_sound(SoundId::PRESENT); // Using existing sound
 
         // Optional: Add points for destroying the pipe
         score += 50;
@@ -541,7 +656,7 @@ void WillyGame::check_collisions() {
     // Only check collision if Willy and ball are at the SAME row AND column
     // AND not in a ballpit
     if (ball.row == y && ball.col == x && current_tile != "BALLPIT") {
-      sound_manager->play_sound("tack.mp3"); // Death sound
+      sound_manager->play_sound(SoundId::TACK); // Death sound
       die();
       return;
     }
@@ -549,10 +664,10 @@ void WillyGame::check_collisions() {
 
   // Check tile interactions
   if (current_tile == "TACK") {
-    // sound_manager->play_sound("tack.mp3");
+    // sound_manager->play_sound(SoundId::TACK);
     die();
   } else if (current_tile == "BELL") {
-    sound_manager->play_sound("bell.mp3");
+    sound_manager->play_sound(SoundId::BELL);
     if (!game_options.one_level) {
          complete_level();
     } else {
@@ -561,13 +676,13 @@ void WillyGame::check_collisions() {
     
   } else if (current_tile == "PRESENT") {
     score += 100;
-    sound_manager->play_sound("present.mp3");
+    sound_manager->play_sound(SoundId::PRESENT);
     set_tile(y, x, "EMPTY");
   } else if (current_tile == "UPSPRING") {
-    sound_manager->play_sound("jump.mp3");
+    sound_manager->play_sound(SoundId::JUMP);
     jump();
   } else if (current_tile == "SIDESPRING") {
-    sound_manager->play_sound("jump.mp3");
+    sound_manager->play_sound(SoundId::JUMP);
     // Reverse continuous direction if moving continuously
     if (moving_continuously) {
       if (continuous_direction == "RIGHT") {
@@ -591,7 +706,7 @@ void WillyGame::check_collisions() {
         for (const auto &ball : balls) {
           if (ball.row == check_y && ball.col == x) {
             score += 20;
-            sound_manager->play_sound("boop.mp3");
+            sound_manager->play_sound(SoundId::BOOP);
             break;
           }
         }
@@ -604,7 +719,7 @@ void WillyGame::die() {
   // Play death sound
   if(!game_options.one_level)
   {
-       sound_manager->play_sound("tack.mp3");
+       sound_manager->play_sound(SoundId::TACK);
   }
 
   // Flash the screen
@@ -680,6 +795,7 @@ void WillyGame::reset_level() {
   moving_continuously = false;
   up_pressed = false;
   down_pressed = false;
+  keys_tapped.clear();
   fps = game_options.fps;
 }
 
@@ -692,16 +808,15 @@ void WillyGame::game_over() {
   }
 }
 
-void WillyGame::new_game() { 
+// The control panel's New Game button; the reset itself happens wherever the
+// game logic runs
+void WillyGame::new_game() { send_input({InputEvent::NEW_GAME}); }
+
+void WillyGame::reset_game() { 
     current_state = GameState::INTRO; 
     printf("FPS is %i\n", game_options.fps);
     fps = game_options.fps;
     
-    // Disconnect the old timer and create a new one with the correct FPS
-    timer_connection.disconnect();
-    timer_connection = Glib::signal_timeout().connect(
-        sigc::mem_fun(*this, &WillyGame::game_tick), 1000 / fps);
-    
     // Reset all game state variables to initial values
     level = game_options.starting_level;
     score = 0;
@@ -712,6 +827,7 @@ void WillyGame::new_game() {
     moving_continuously = false;
     up_pressed = false;
     down_pressed = false;
+    keys_tapped.clear();
     life_adder = 0;
     
     // Reset Willy's position and state - get the proper start position from the level
@@ -729,16 +845,347 @@ void WillyGame::new_game() {
     
     // Set the current level name
     current_level = "level" + std::to_string(level);
-    
-    // Update the status bar
-    update_status_bar();
 }
 
-void WillyGame::quit_game() { hide(); }
+void WillyGame::quit_game() {
+  quitting = true;
+  update_tick_timer();
+  if (gamepad) {
+    gamepad->stop();
+  }
+  stop_sim_thread();
+  sound_manager->cleanup(); // Nothing can ask for a sound any more
+
+  if (pacer.get_measured_rate() > 0) {
+    std::cout << "Tick rate: " << pacer.get_measured_rate() << " Hz (target "
+              << pacer.get_target_rate() << "), jitter "
+              << pacer.get_jitter_ms() << " ms" << std::endl;
+  }
+  if (input_events_applied > 0) {
+    std::cout << "Input latency: "
+              << input_latency_total / 1000.0 / input_events_applied
+              << " ms average over " << input_events_applied << " events"
+              << std::endl;
+  }
+
+  if (frame_capture) {
+    frame_capture->finish();
+  }
+
+  if (!game_window) {
+    if (headless_loop) {
+      headless_loop->quit();
+    }
+  } else if (renderer && !renderer->draws_in_widget()) {
+    // The window was never shown, so hiding it would not end the application
+    auto app = game_window->get_application();
+    if (app) {
+      app->remove_window(*game_window);
+    }
+  } else {
+    game_window->hide();
+  }
+}
+
+void WillyGame::run_headless() {
+  headless_loop = Glib::MainLoop::create();
+  headless_loop->run();
+  headless_loop.reset();
+}
+
+void WillyGame::on_window_hidden() {
+  quitting = true;
+  update_tick_timer();
+  if (gamepad) {
+    gamepad->stop();
+  }
+  stop_sim_thread();
+  sound_manager->cleanup();
+
+  // Closing the window ends the application, so flush the capture now
+  if (frame_capture) {
+    frame_capture->finish();
+  }
+}
+
+void WillyGame::capture_frame() {
+  if (!frame_capture || !frame_capture->wants_frame(frames_rendered)) {
+    return;
+  }
+
+  Cairo::RefPtr<Cairo::ImageSurface> frame = renderer->get_frame();
+  if (!frame && capture_target) {
+    swap_capture_state();
+    capture_target->request_frame();
+    swap_capture_state();
+    frame = capture_target->get_frame();
+  }
+  if (frame) {
+    frame_capture->submit(frame->get_data(), frame->get_width(),
+                          frame->get_height(), frame->get_stride(),
+                          frames_rendered,
+                          game_options.backend == RenderBackend::HEADLESS);
+  }
+}
+
+// Trades the window's viewport and cached surfaces for the capture target's,
+// or back again
+void WillyGame::swap_capture_state() {
+  std::swap(viewport, capture_state.viewport);
+  std::swap(intro_cache, capture_state.intro_cache);
+  std::swap(high_score_cache, capture_state.high_score_cache);
+  std::swap(frame_surface, capture_state.frame_surface);
+  drawing_capture = !drawing_capture;
+}
+
+void WillyGame::start_tick_timer() {
+  stop_tick_timer();
+  if (renderer && renderer->draws_in_widget()) {
+    // Draw at the display's rate; on_frame_clock steps the game at fps
+    pacer.start(view->fps, g_get_monotonic_time());
+    // So a resume doesn't draw a step back. The sim thread owns the game
+    // state; there a snapshot's age sets the interpolation, and a stale
+    // one is drawn where it ended.
+    if (!sim_thread.joinable()) {
+      save_interpolation_start();
+    }
+    frame_callback_id = game_window->drawing_area.add_tick_callback(
+        sigc::mem_fun(*this, &WillyGame::on_frame_clock));
+  } else if (game_options.backend == RenderBackend::HEADLESS) {
+    // Nothing to look at, so tick as fast as the frames can be made
+    timer_connection =
+        Glib::signal_idle().connect(sigc::mem_fun(*this, &WillyGame::game_tick));
+  } else {
+    pacer.start(view->fps, g_get_monotonic_time());
+    schedule_next_tick();
+  }
+}
+
+// Arms a one-shot timeout for the pacer's next deadline. Rounding up means
+// the wake-up is never early; lateness is absorbed by the next deadline.
+void WillyGame::schedule_next_tick() {
+  gint64 wait = pacer.next_deadline() - g_get_monotonic_time();
+  timer_connection.disconnect();
+  timer_connection = Glib::signal_timeout().connect(
+      sigc::mem_fun(*this, &WillyGame::on_tick_deadline),
+      std::max<gint64>(0, (wait + 999) / 1000), Glib::PRIORITY_HIGH);
+}
+
+bool WillyGame::on_tick_deadline() {
+  int due = pacer.ticks_due(g_get_monotonic_time());
+  for (int i = 0; i < due; i++) {
+    if (!game_tick() || tick_mode != TickMode::RUNNING) {
+      return false;
+    }
+  }
+  schedule_next_tick();
+  return false;
+}
+
+void WillyGame::stop_tick_timer() {
+  timer_connection.disconnect();
+  if (frame_callback_id) {
+    game_window->drawing_area.remove_tick_callback(frame_callback_id);
+    frame_callback_id = 0;
+  }
+  // Anything drawn while stopped shows the state as it is
+  frame_interpolation = 1.0;
+}
+
+bool WillyGame::wants_ticks() const {
+  if (quitting) {
+    return false;
+  }
+  // Headless runs and captures produce frames at a steady rate regardless
+  if (game_options.backend == RenderBackend::HEADLESS || frame_capture) {
+    return true;
+  }
+  if (!window_active) {
+    return false;
+  }
+  // Every other screen only changes on input
+  return view->state == GameState::PLAYING || view->flash_ticks_left > 0;
+}
+
+void WillyGame::update_tick_timer() {
+  TickMode mode = TickMode::STOPPED;
+  if (wants_ticks()) {
+    mode = TickMode::RUNNING;
+  } else if (!quitting && renderer && renderer->needs_polling()) {
+    mode = TickMode::POLLING;
+  }
+  if (mode == tick_mode) {
+    return;
+  }
+
+  tick_mode = mode;
+  main_idle = mode != TickMode::RUNNING;
+  if (mode == TickMode::RUNNING) {
+    start_tick_timer();
+  } else if (mode == TickMode::POLLING) {
+    // SDL input only arrives when asked for, so check ten times a second
+    stop_tick_timer();
+    timer_connection = Glib::signal_timeout().connect(
+        sigc::mem_fun(*this, &WillyGame::poll_while_idle), 100);
+  } else {
+    stop_tick_timer();
+  }
+
+  // A snapshot published just before main_idle was set found the GTK side
+  // still running and sent no nudge, so look once more now that it's idle
+  if (main_idle && sim_thread.joinable() && refresh_view()) {
+    wake();
+  }
+}
+
+bool WillyGame::poll_while_idle() {
+  int old_width, old_height;
+  renderer->get_size(old_width, old_height);
+
+  if (!renderer->poll_events()) {
+    quit_game();
+    return false;
+  }
+
+  int width, height;
+  renderer->get_size(width, height);
+  if (width != old_width || height != old_height) {
+    wake();
+  }
+  return true;
+}
+
+// Repaints once after something changed and restarts the tick timer if the
+// new state needs it
+void WillyGame::wake() {
+  if (quitting || !renderer) {
+    return;
+  }
+  refresh_view();
+  if (!renderer->draws_in_widget()) {
+    update_viewport();
+  }
+  renderer->request_frame();
+  update_tick_timer();
+}
+
+void WillyGame::set_window_active(bool active) {
+  if (active == window_active) {
+    return;
+  }
+  window_active = active;
+
+  if (!active) {
+    send_input({InputEvent::FOCUS_LOST});
+  }
+  wake();
+}
+
+bool WillyGame::on_focus_change(GdkEventFocus *event) {
+  set_window_active(event->in);
+  return false;
+}
+
+bool WillyGame::on_window_state_change(GdkEventWindowState *event) {
+  const int hidden = GDK_WINDOW_STATE_ICONIFIED | GDK_WINDOW_STATE_WITHDRAWN;
+  if (event->changed_mask & hidden) {
+    set_window_active(!(event->new_window_state & hidden));
+  }
+  return false;
+}
+
+void WillyGame::pause_game() {
+  current_state = GameState::PAUSED;
+  std::cout << "Game paused" << std::endl;
+}
+
+void WillyGame::resume_game() {
+  current_state = GameState::PLAYING;
+  std::cout << "Game resumed" << std::endl;
+}
 
 bool WillyGame::game_tick() {
-  if (current_state == GameState::PLAYING) {
+  if (!renderer->poll_events()) {
+    quit_game();
+    return false;
+  }
+
+  // With --sim-thread the game has moved on by itself; just show the latest
+  if (!sim_thread.joinable()) {
+    simulate_tick();
+  }
+  refresh_view();
+
+  if (!renderer->draws_in_widget()) {
+    update_viewport();
+  }
+  renderer->request_frame();
+  return finish_tick();
+}
+
+// Called by GTK once per display refresh while the game is running
+bool WillyGame::on_frame_clock(const Glib::RefPtr<Gdk::FrameClock> &clock) {
+  gint64 now = clock->get_frame_time();
+
+  if (sim_thread.joinable()) {
+    // Each new snapshot counts as a step for captures and --frames
+    if (refresh_view()) {
+      frame_interpolation = 1.0;
+      if (!finish_tick()) {
+        return true;
+      }
+    }
+    frame_interpolation = std::max(
+        0.0, std::min(1.0, (now - view->tick_time) * view->fps / 1000000.0));
+    renderer->request_frame();
+    return true;
+  }
+
+  // The pacer skips ahead after a stall rather than fast-forwarding through it
+  int due = pacer.ticks_due(now);
+  for (int i = 0; i < due && tick_mode == TickMode::RUNNING; i++) {
+    simulate_tick();
+    refresh_view();
+    frame_interpolation = 1.0; // captures record the finished step
+    if (!finish_tick()) {
+      return true;
+    }
+  }
+
+  if (tick_mode == TickMode::RUNNING) {
+    frame_interpolation = pacer.get_phase(now);
+  }
+  renderer->request_frame();
+  return true;
+}
+
+// Sprites are drawn moving from here towards where the next step leaves them
+void WillyGame::save_interpolation_start() {
+  willy_interp_from = willy_position;
+  for (auto &ball : balls) {
+    ball.prev_row = ball.row;
+    ball.prev_col = ball.col;
+  }
+}
+
+// Advances the game by one step of 1/fps
+void WillyGame::simulate_tick() {
+  save_interpolation_start();
+  sound_manager->begin_tick();
+
+  // The game holds still while the death flash is up, as it always has, but
+  // the loop keeps ticking and drawing
+  bool flashing = flash_ticks_left > 0;
+  if (flashing) {
+    flash_ticks_left--;
+  }
+
+  // Input that arrived since the last tick, in the order it arrived
+  drain_input();
+
+  if (current_state == GameState::PLAYING && !flashing) {
     update_willy_movement();
+    keys_tapped.clear();
     update_balls();
     check_collisions();
 
@@ -757,35 +1204,55 @@ bool WillyGame::game_tick() {
 
         // Play a sound for extra life
         sound_manager->play_sound(
-            "bell.mp3"); // Or create a special extra life sound
+            SoundId::BELL); // Or create a special extra life sound
       }
 
       // Check for time warnings
       if ((bonus <= 100 && old_bonus > 100) ||
           (bonus <= 50 && old_bonus > 50)) {
         std::cout << "Warning: Time running low!" << std::endl;
-        sound_manager->play_sound("bell.mp3"); // Warning sound
+        sound_manager->play_sound(SoundId::BELL); // Warning sound
       }
 
       // Check if timer ran out - Willy dies!
       if (bonus <= 0) {
         std::cout << "Time's up! Bonus reached zero - Willy dies!" << std::endl;
-        sound_manager->play_sound("tack.mp3"); // Death sound
+        sound_manager->play_sound(SoundId::TACK); // Death sound
         die();                                 // Kill Willy when timer expires
-        return true; // Exit early since we're now in death/reset state
       }
     }
-    update_status_bar();
   }
-  drawing_area.queue_draw();
 
+  // Whatever this step asked to hear, once each
+  sound_manager->end_tick();
+}
+
+// Bookkeeping after each simulation step. Returns false once the game quits.
+bool WillyGame::finish_tick() {
+  capture_frame();
+
+  frames_rendered++;
+  if (game_options.max_frames > 0 &&
+      frames_rendered >= game_options.max_frames) {
+    std::cout << "Rendered " << frames_rendered << " frames, quitting"
+              << std::endl;
+    quit_game();
+    return false;
+  }
+
+  // Stops the timer once the game lands on a screen that holds still
+  update_tick_timer();
   return true; // Continue the timer
 }
 
 void WillyApplication::on_activate() {
-  auto window = new WillyGame();
-  add_window(*window);
-  window->present();
+  auto game = new WillyGame();
+  Gtk::Window &window = game->get_game_window();
+  add_window(window);
+  // SDL runs draw elsewhere; the GTK window stays hidden
+  if (game_options.backend == RenderBackend::GTK) {
+    window.present();
+  }
 }
 
 // Function to run the game with specific options (called from editor)
@@ -800,6 +1267,8 @@ int run_willy_game(const GameOptions &options) {
   std::cout << "Number of balls: " << game_options.number_of_balls << "\n";
   std::cout << "FPS: " << game_options.fps << "\n";
   std::cout << "Scale factor: " << game_options.scale_factor << "\n";
+  std::cout << "Renderer: " << render_backend_name(game_options.backend)
+            << "\n";
   if (game_options.use_wasd)
     std::cout << "Using WASD controls\n";
   if (game_options.disable_flash)
@@ -810,6 +1279,15 @@ int run_willy_game(const GameOptions &options) {
     std::cout << "Sound disabled\n";
   std::cout << "\n";
 
+  // Headless runs skip GTK entirely: Cairo and Pango draw into memory and a
+  // plain main loop drives the ticks, so no display is needed
+  if (game_options.backend == RenderBackend::HEADLESS) {
+    Glib::init();
+    WillyGame game;
+    game.run_headless();
+    return 0;
+  }
+
   // Create a new argc/argv with only the program name for GTK
   int gtk_argc = 1;
   char program_name[] = "willy";
@@ -2,10 +2,16 @@
 #define WILLY_H
 
 #include <algorithm>
+#include <atomic>
+#include <bitset>
 #include <cairomm/cairomm.h>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <gtkmm.h>
 #include <iostream>
 #include <map>
@@ -25,10 +31,30 @@
 #include <string>
 #include <thread>
 
+#include "assets.h"
+#include "lockfree.h"
+#include "pixels.h"
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+// Where frames are drawn: the GTK window, an SDL2 window or an offscreen
+// surface with nothing on screen
+enum class RenderBackend { GTK, SDL, HEADLESS };
+
+bool parse_render_backend(const std::string &name, RenderBackend &backend);
+const char *render_backend_name(RenderBackend backend);
+
+// Where the sound effects come from: the MP3s in audio/, square waves made
+// at startup like the PC speaker the original used, nowhere, or a log file
+enum class SoundMode { FILES, SYNTH, NONE, RECORD };
+
+// "record:FILE" also sets record_file
+bool parse_sound_mode(const std::string &name, SoundMode &mode,
+                      std::string &record_file);
+const char *sound_mode_name(SoundMode mode);
+
 // Global variables to store command line options (add these near the top of
 // willy.cpp)
 struct GameOptions {
@@ -44,26 +70,219 @@ struct GameOptions {
   bool show_help = false;
   int starting_lives = 5;
   bool one_level = false;
+  SpriteFilter sprite_filter = SpriteFilter::NEAREST;
+  RenderBackend backend = RenderBackend::GTK;
+  int max_frames = 0; // Quit after this many frames (0 = run until closed)
+  std::string capture_dir;            // Save frames here as images
+  int capture_every = 1;              // ...one every N frames
+  std::string capture_format = "png"; // png or ppm
+  std::string export_video;           // Stream every frame to this .y4m file
+  bool sim_thread = false; // Run the game logic on its own thread
+  bool gamepad = false;         // Read SDL game controllers
+  int gamepad_deadzone = 35;    // Percent of stick travel ignored
+  std::string gamepad_bindings; // Changes to the default bindings
+  int audio_rate = 22050;       // Mixer sample rate in Hz
+  int audio_buffer = 1024;      // Mixer buffer in sample frames
+  SoundMode sound_mode = SoundMode::FILES;
+  std::string sound_record_file; // With SoundMode::RECORD
 };
 
-class SoundManager {
+// SDL's subsystem init and quit calls share reference counts and aren't
+// thread-safe, and the audio device is opened on the sound worker while the
+// GTK thread sets up video and gamepads. Hold this around every
+// SDL_Init/SDL_InitSubSystem/SDL_QuitSubSystem call.
+extern std::mutex sdl_subsystem_mutex;
+
+// Every sound effect in audio/. They are all decoded at startup, so playing
+// one is just an index into a table.
+enum class SoundId { BELL, BOOP, JUMP, LADDER, PRESENT, TACK, COUNT };
+const int SOUND_COUNT = static_cast<int>(SoundId::COUNT);
+const char *sound_name(SoundId id);
+std::string sound_file_name(SoundId id);
+bool synthesize_sound(SoundId id, int rate, Uint16 format, int channels,
+                      std::vector<Uint8> &pcm);
+
+// Decoded sounds saved at the mixer's output format, so later launches can
+// skip decoding. Each entry remembers the size, mtime and contents hash of
+// the file it came from and is only used while all three still match.
+class SoundCache {
+public:
+  struct Source {
+    std::string name;
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    uint64_t hash = 0;
+  };
+
 private:
-  std::map<std::string, Mix_Chunk *> sound_cache;
-  std::mutex sound_mutex;
-  bool sound_enabled;
-  bool initialized;
+  std::string path;
+  int rate;
+  Uint16 format;
+  int channels;
 
-  std::string find_sound_file(const std::string &filename);
+  uint8_t *data = nullptr; // The whole cache file
+  size_t data_size = 0;
+  bool mapped = false;
+  std::vector<uint8_t> contents; // Used instead of a mapping on Windows
 
 public:
-  SoundManager();
-  ~SoundManager();
+  SoundCache(const std::string &path, int rate, Uint16 format, int channels);
+  ~SoundCache();
+
+  // ~/.willytheworm/cache/sounds.pcm, creating the directories
+  static std::string default_path();
+  static bool describe(const std::string &file_path, const std::string &name,
+                       Source &source);
+  static void describe(const EmbeddedAsset &asset, const std::string &name,
+                       Source &source);
+
+  // Maps the cache file. Fails if it's missing, damaged or was made for a
+  // different mixer format.
+  bool open();
+  // PCM for source if the cache has an up-to-date copy. It points into the
+  // mapping and stays valid until the cache is destroyed.
+  uint8_t *find(const Source &source, uint32_t &length) const;
+  // Replaces the cache file with these sounds
+  bool save(
+      const std::vector<std::pair<Source, const Mix_Chunk *>> &sounds) const;
+};
+
+const int MIXER_CHANNELS = 16;
+
+// Anything that takes the game's sound effects. play_sound is called from the
+// game logic thread, and each simulation step is wrapped in begin_tick() and
+// end_tick().
+class AudioBackend {
+protected:
+  bool sound_enabled = true;
 
-  bool initialize();
-  void cleanup();
-  void play_sound(const std::string &filename);
+public:
+  virtual ~AudioBackend() = default;
+
+  virtual const char *get_name() const = 0;
+  virtual bool initialize() = 0;
+  // Stops whatever is playing and lets go of the device; safe to repeat
+  virtual void cleanup() {}
+  virtual void play_sound(SoundId id) = 0;
+  virtual void begin_tick() {}
+  virtual void end_tick() {}
   void set_sound_enabled(bool enabled) { sound_enabled = enabled; }
   bool is_sound_enabled() const { return sound_enabled; }
+};
+
+// Drops every sound: no audio device, no threads. The default for headless
+// runs, which then pay nothing for audio.
+class NullAudio : public AudioBackend {
+public:
+  const char *get_name() const override { return "none"; }
+  bool initialize() override { return true; }
+  void play_sound(SoundId) override {}
+};
+
+// Writes a "TICK SOUND" line, e.g. "42 jump", for each sound instead of
+// playing it, so a run's sounds can be checked against an expected timeline.
+// Like the mixer, a sound is only written once per tick. Sounds between
+// ticks get the number of the last one.
+class RecordingAudio : public AudioBackend {
+private:
+  std::string path;
+  std::ofstream out;
+  long tick = 0;
+  bool in_tick = false;
+  uint32_t written = 0; // One bit per SoundId already written this tick
+
+public:
+  explicit RecordingAudio(const std::string &path);
+
+  const char *get_name() const override { return "record"; }
+  bool initialize() override;
+  void cleanup() override;
+  void play_sound(SoundId id) override;
+  void begin_tick() override;
+  void end_tick() override;
+};
+
+// Sounds are started by one long-lived worker thread. The game only drops a
+// small command into a lock-free queue, so play_sound never blocks,
+// allocates or touches the disk.
+//
+// The worker also opens the audio device and loads the sounds before it
+// starts playing, since some sound servers take a long time to answer.
+// Sounds asked for meanwhile wait in the queue.
+//
+// Within a simulation tick, sounds are collected between begin_tick() and
+// end_tick(). Each sound plays at most once per tick and quick repeats are
+// held off by a per-sound cooldown. When every channel is busy, a sound
+// takes over the channel of a less important one.
+class SoundManager : public AudioBackend {
+private:
+  struct Command {
+    SoundId id;
+    gint64 requested; // When the game asked for it
+  };
+
+  enum class DeviceState { OPENING, READY, FAILED };
+
+  // What each mixer channel was last asked to play; worker only
+  struct Voice {
+    int priority = -1;
+    gint64 started = 0;
+  };
+
+  std::array<Mix_Chunk *, SOUND_COUNT> chunks{};
+  std::unique_ptr<SoundCache> pcm_cache; // Backs chunks loaded from it
+  std::array<std::vector<Uint8>, SOUND_COUNT> synth_pcm; // Backs synth chunks
+  SoundMode mode;
+  MpscQueue<Command, 64> commands;
+  SDL_sem *commands_waiting = nullptr;
+  std::thread worker;
+  std::atomic<bool> stopping{false};
+  std::atomic<int> dropped{0};
+  std::atomic<DeviceState> device_state{DeviceState::OPENING};
+  bool initialized; // The worker is running
+
+  // Game logic thread only
+  bool batching = false;
+  uint32_t pending = 0; // One bit per SoundId
+  std::array<gint64, SOUND_COUNT> last_sent{};
+  std::array<gint64, SOUND_COUNT> requested_at{}; // Earliest ask this tick
+
+  std::array<Voice, MIXER_CHANNELS> voices;
+  int voices_stolen = 0;
+  int voices_unavailable = 0;
+  int too_late = 0; // Waited so long that playing them would confuse
+
+  // When each channel's sound was asked for, until the mixer first mixes it
+  std::array<std::atomic<gint64>, MIXER_CHANNELS> awaiting_mix{};
+  // Written by the mixer callback; read once it has been removed
+  gint64 mix_latency_total = 0;
+  gint64 mix_latency_worst = 0;
+  int mix_latency_count = 0;
+  int buffer_frames;
+  int sample_rate; // Asked for until the device is open, then what we got
+
+  std::string find_sound_file(const std::string &filename);
+  bool open_device();
+  void worker_loop();
+  void preload_sounds();
+  void synthesize_sounds();
+  void play_now(SoundId id, gint64 requested);
+  void send(SoundId id, gint64 requested);
+  int steal_voice(int priority);
+  static void on_post_mix(void *udata, Uint8 *stream, int len);
+
+public:
+  // rate and frames set the mixer's sample rate and buffer size; the buffer
+  // alone adds frames / rate seconds before a sound is heard
+  SoundManager(SoundMode mode, int rate, int frames);
+  ~SoundManager();
+
+  const char *get_name() const override { return "sdl"; }
+  bool initialize() override;
+  void cleanup() override;
+  void play_sound(SoundId id) override;
+  void begin_tick() override;
+  void end_tick() override;
   void stop_all_sounds();
   void set_master_volume(int volume);
   int get_playing_channels();
@@ -79,6 +298,10 @@ class HighScoreManager {
 private:
   std::vector<HighScore> permanent_scores; // All-time "Nightcrawlers"
   std::vector<HighScore> daily_scores;     // Daily "Pinworms"
+  int version = 0; // Bumped whenever the tables change
+  // The tables are written by the game logic and read by the drawing code,
+  // which may be on different threads
+  mutable std::mutex mutex;
 
   std::string get_score_file_path();
   bool is_new_day(const std::string &file_path);
@@ -98,6 +321,10 @@ public:
   std::string get_achievement_message(int score);
   std::vector<HighScore> get_permanent_scores() const;
   std::vector<HighScore> get_daily_scores() const;
+  int get_version() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return version;
+  }
 };
 
 // Game constants
@@ -120,11 +347,131 @@ enum class GameState {
 
 struct Ball {
   int row, col;
+  int prev_row, prev_col; // Where the last simulation step started
   std::string direction;
 
   Ball(int r = 0, int c = 0);
 };
 
+// Where the game lands in the render target: game pixel (0, 0) sits at
+// origin, just under the menubar, and everything is scaled by scale. Worked
+// out once per size change and used both to draw and to turn mouse
+// positions back into game coordinates.
+struct Viewport {
+  // The window and render target sizes it was worked out for
+  int window_width = -1, window_height = -1;
+  int target_width = -1, target_height = -1;
+  int menubar_height = 0;
+  double scale = 1.0;
+  double origin_x = 0.0;
+  double origin_y = 0.0;
+  int cell_width = GAME_CHAR_WIDTH; // One character cell in game pixels
+  int cell_height = GAME_CHAR_HEIGHT;
+
+  void apply(const Cairo::RefPtr<Cairo::Context> &cr) const {
+    cr->translate(origin_x, origin_y);
+    cr->scale(scale, scale);
+  }
+  double to_game_x(double x) const { return (x - origin_x) / scale; }
+  double to_game_y(double y) const { return (y - origin_y) / scale; }
+  // {row, col} of the cell under a point; may be off the grid
+  std::pair<int, int> to_cell(double x, double y) const {
+    return {(int)std::floor(to_game_y(y) / cell_height),
+            (int)std::floor(to_game_x(x) / cell_width)};
+  }
+};
+
+// Everything the drawing code needs from one simulation step. With
+// --sim-thread these are handed from the simulation to the GTK thread through
+// a TripleBuffer; otherwise one is refreshed in place before each frame.
+struct GameSnapshot {
+  GameState state = GameState::INTRO;
+  // Tile names row by row; only recopied when grid_version or the level moves
+  std::vector<std::string> tiles;
+  int grid_version = -1;
+  std::string level_name;
+  std::vector<Ball> balls;
+  std::pair<int, int> willy_position{23, 7};
+  std::pair<int, int> willy_interp_from{23, 7};
+  std::string willy_direction = "RIGHT";
+  int score = 0;
+  int bonus = 0;
+  int level = 0;
+  int lives = 0;
+  int flash_ticks_left = 0;
+  bool flash_strobe = false;
+  std::string name_input;
+  int fps = 10;
+  int64_t tick_time = 0; // Monotonic time the step finished, in microseconds
+
+  // Same answer as WillyGame::get_tile, including EMPTY off the grid
+  const std::string &tile(int row, int col) const {
+    static const std::string empty = "EMPTY";
+    if (row < 0 || row >= GAME_MAX_HEIGHT || col < 0 || col >= GAME_MAX_WIDTH ||
+        tiles.empty()) {
+      return empty;
+    }
+    return tiles[row * GAME_MAX_WIDTH + col];
+  }
+};
+
+// Input headed for the game logic. Keys and buttons come from the window;
+// the rest are things the GTK side asks the simulation to do.
+struct InputEvent {
+  enum Type {
+    KEY_PRESS,
+    KEY_RELEASE,
+    BUTTON_PRESS,
+    BUTTON_RELEASE,
+    FOCUS_LOST,
+    NEW_GAME
+  };
+  Type type = KEY_PRESS;
+  guint keyval = 0;
+  guint state = 0;
+  int button = 0;
+  double x = 0.0, y = 0.0; // Unscaled game coordinates for buttons
+  gint64 time = 0;         // g_get_monotonic_time() when it arrived
+};
+
+// A set of keys, one bit each. Latin-1 keyvals and the 0xff00 block (arrows,
+// Return, function keys) cover every key the game looks at; anything else is
+// ignored. Letters are stored lower case so Shift can't leave one stuck.
+class KeySet {
+private:
+  std::bitset<512> bits;
+
+  static int index(guint keyval) {
+    keyval = gdk_keyval_to_lower(keyval);
+    if (keyval < 0x100) {
+      return keyval;
+    }
+    if (keyval >= 0xff00 && keyval <= 0xffff) {
+      return 0x100 + (keyval & 0xff);
+    }
+    return -1;
+  }
+
+public:
+  void set(guint keyval) {
+    int i = index(keyval);
+    if (i >= 0) {
+      bits.set(i);
+    }
+  }
+  void reset(guint keyval) {
+    int i = index(keyval);
+    if (i >= 0) {
+      bits.reset(i);
+    }
+  }
+  bool test(guint keyval) const {
+    int i = index(keyval);
+    return i >= 0 && bits.test(i);
+  }
+  void clear() { bits.reset(); }
+};
+
 class LevelLoader {
 private:
   // Level data structure: level_name -> row -> col -> tile_type
@@ -195,11 +542,17 @@ public:
 class SpriteLoader {
 private:
   int scale_factor;
+  SpriteFilter filter;
   std::map<std::string, Cairo::RefPtr<Cairo::ImageSurface>> sprites;
   std::map<std::string, std::string> named_parts;
+  // 1-bit glyph rows (as filtered) kept for the indexed framebuffer. Empty
+  // when the fallback sprites are in use.
+  std::map<std::string, std::vector<uint32_t>> glyph_masks;
+  int mask_size = 0;
 
 public:
-  explicit SpriteLoader(int scale = 3);
+  explicit SpriteLoader(int scale = 3,
+                        SpriteFilter filter = SpriteFilter::NEAREST);
 
   std::string find_chr_file();
   void load_sprites();
@@ -207,6 +560,8 @@ public:
   void load_old_format(const std::vector<uint8_t> &data);
   Cairo::RefPtr<Cairo::ImageSurface>
   create_sprite_from_bitmap(const std::vector<uint8_t> &data, int char_index);
+  Cairo::RefPtr<Cairo::ImageSurface> create_sprite_from_mask(const uint32_t *rows,
+                                                             int mask_size);
   void create_fallback_sprites();
   Cairo::RefPtr<Cairo::ImageSurface> create_willy_sprite(bool facing_right);
   Cairo::RefPtr<Cairo::ImageSurface> create_colored_rect(double r, double g,
@@ -218,18 +573,357 @@ public:
   Cairo::RefPtr<Cairo::ImageSurface> create_spring_sprite(bool upward);
   Cairo::RefPtr<Cairo::ImageSurface> create_empty_sprite();
   Cairo::RefPtr<Cairo::ImageSurface> get_sprite(const std::string &name);
+  const uint32_t *get_mask(const std::string &name) const;
+  int get_mask_size() const { return mask_size; }
+  bool has_masks() const { return !glyph_masks.empty(); }
+};
+
+// Expands fb into surface (recreated when the size changes) and paints it at
+// the given scale. Whole-number screen scales are done entirely in software
+// with nearest sampling; otherwise the nearest integer prescale is finished
+// off with a bilinear paint.
+void paint_indexed_framebuffer(const Cairo::RefPtr<Cairo::Context> &cr,
+                               const IndexedFramebuffer &fb,
+                               Cairo::RefPtr<Cairo::ImageSurface> &surface,
+                               double scale);
+
+// Monospace text drawn from a pre-rasterized glyph atlas
+class BitmapFont {
+private:
+  std::vector<gunichar> glyphs;
+  std::map<gunichar, int> glyph_index;
+  int cell_width = 1;
+  int cell_height = 1;
+  Cairo::RefPtr<Cairo::ImageSurface> atlas; // A8, one cell per glyph
+  std::map<uint32_t, Cairo::RefPtr<Cairo::ImageSurface>> tinted;
+
+  Cairo::RefPtr<Cairo::ImageSurface> get_tinted_atlas(double r, double g,
+                                                      double b);
+
+public:
+  BitmapFont(const std::string &family, int point_size);
+
+  int get_cell_width() const { return cell_width; }
+  int get_cell_height() const { return cell_height; }
+  int measure(const std::string &text) const;
+  // (x, y) is the top left of the text, as with a Pango layout
+  void draw_text(const Cairo::RefPtr<Cairo::Context> &cr, double x, double y,
+                 const std::string &text, double r, double g, double b);
+};
+
+// Schedules simulation ticks against absolute deadlines, origin + n/rate,
+// so rounding and late wake-ups never add up to drift. Times are in
+// microseconds of the monotonic clock (g_get_monotonic_time, which is also
+// what GdkFrameClock reports).
+class FramePacer {
+private:
+  int rate = 60;
+  int max_catch_up;
+  int64_t origin = 0;
+  int64_t next_tick = 1;
+
+  // Measurement over the last whole second
+  int64_t window_start = 0;
+  int window_ticks = 0;
+  int64_t window_lateness = 0;
+  double measured_rate = 0.0;
+  double jitter_ms = 0.0;
+
+  int64_t deadline(int64_t tick) const {
+    return origin + tick * 1000000 / rate;
+  }
+
+public:
+  explicit FramePacer(int max_catch_up = 5);
+
+  void start(int ticks_per_second, int64_t now);
+  // How many ticks are due by now. After a stall longer than max_catch_up
+  // ticks the rest are dropped and the schedule restarts from now.
+  int ticks_due(int64_t now);
+  int64_t next_deadline() const { return deadline(next_tick); }
+  // How far now is between the last tick and the next one, 0 to 1
+  double get_phase(int64_t now) const;
+
+  int get_target_rate() const { return rate; }
+  double get_measured_rate() const { return measured_rate; }
+  // Average time ticks ran after their deadline
+  double get_jitter_ms() const { return jitter_ms; }
+};
+
+// Saves rendered frames as PNG/PPM images and/or a YUV4MPEG2 stream. Frames
+// are copied into a small pool of buffers and written out by a worker
+// thread, so the game tick only pays for a memcpy.
+class FrameCapture {
+private:
+  struct Frame {
+    std::vector<uint8_t> pixels;
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    int number = 0;
+  };
+
+  std::string image_dir;
+  int image_every;
+  std::string image_format;
+  std::string video_path;
+  int video_fps;
+
+  std::vector<Frame> frames;
+  std::deque<int> free_frames;
+  std::deque<int> pending_frames;
+  std::mutex queue_mutex;
+  std::condition_variable queue_changed;
+  std::thread writer;
+  bool stopping = false;
+  int dropped = 0;
+
+  std::ofstream video;
+  int video_width = 0;
+  int video_height = 0;
+  int video_mismatches = 0;
+  std::vector<uint8_t> yuv;
+
+  void writer_loop();
+  void write_image(const Frame &frame);
+  void write_video_frame(const Frame &frame);
+
+public:
+  FrameCapture(const std::string &image_dir, int image_every,
+               const std::string &image_format, const std::string &video_path,
+               int video_fps, int buffers = 2);
+  ~FrameCapture();
+
+  bool start();
+  bool wants_frame(int frame_number) const;
+  // Copies an ARGB32 frame into a free buffer. When none is free the frame
+  // is dropped, unless wait is set (headless runs, where nobody is watching
+  // the clock).
+  void submit(const uint8_t *pixels, int width, int height, int stride,
+              int frame_number, bool wait);
+  // Writes everything still queued and stops the writer thread
+  void finish();
+};
+
+// Reads SDL game controllers on a thread of its own and turns them into key
+// presses and releases, so a gamepad plays through the same code as the
+// keyboard. Controllers can be plugged in and pulled out at any time.
+class GamepadInput {
+public:
+  // One controller input, a button or one direction of a stick, and the key
+  // it stands for
+  struct Binding {
+    int button = -1; // SDL_GameControllerButton, or -1 for an axis
+    int axis = -1;   // SDL_GameControllerAxis
+    int sign = 0;    // Which way the axis must be pushed
+    guint keyval = 0;
+    bool active = false;
+  };
+
+private:
+  std::vector<Binding> bindings;
+  int deadzone; // In axis units
+  std::map<SDL_JoystickID, SDL_GameController *> controllers;
+  std::map<guint, int> key_holds; // Active bindings per key
+  SpscQueue<InputEvent, 256> events;
+  std::function<void()> notify;
+
+  std::thread poller;
+  std::atomic<bool> stopping{false};
+  std::mutex stop_mutex;
+  std::condition_variable stop_requested;
+  bool initialized = false;
+
+  void poll_loop();
+  void scan_controllers();
+  bool is_pushed(SDL_GameController *controller, const Binding &binding) const;
+
+public:
+  GamepadInput(const std::vector<Binding> &bindings, int deadzone_percent);
+  ~GamepadInput();
+
+  static std::vector<Binding> default_bindings();
+  // Applies "a=space,leftx-=Left,back=none" on top of bindings. Inputs use
+  // SDL's controller names, keys use GDK's key names.
+  static bool parse_bindings(const std::string &spec,
+                             std::vector<Binding> &bindings);
+
+  // on_input is called from the polling thread whenever events are waiting
+  bool start(std::function<void()> on_input);
+  void stop();
+  bool pop(InputEvent &event) { return events.pop(event); }
+};
+
+using FrameDrawer = std::function<void(const Cairo::RefPtr<Cairo::Context> &)>;
+using KeyHandler = std::function<bool(GdkEventKey *)>;
+// Told true when the window can be seen and has focus, false otherwise
+using ActivityHandler = std::function<void(bool)>;
+
+// The screens are always drawn with Cairo. A renderer decides what the
+// context draws into and how the finished frame reaches the user.
+class Renderer {
+protected:
+  FrameDrawer draw_frame;
+  KeyHandler key_press;
+  KeyHandler key_release;
+  ActivityHandler activity_changed;
+
+public:
+  virtual ~Renderer() = default;
+
+  void set_frame_drawer(FrameDrawer drawer) { draw_frame = drawer; }
+  void set_key_handlers(KeyHandler press, KeyHandler release) {
+    key_press = press;
+    key_release = release;
+  }
+  void set_activity_handler(ActivityHandler handler) {
+    activity_changed = handler;
+  }
+
+  virtual const char *get_name() const = 0;
+  virtual bool initialize() = 0;
+  // True when frames are drawn from the GTK widget's draw signal
+  virtual bool draws_in_widget() const { return false; }
+  // Draws a frame now, or schedules one for the next paint
+  virtual void request_frame() = 0;
+  virtual void get_size(int &width, int &height) const = 0;
+  // Last finished frame for offscreen backends, null for GTK
+  virtual Cairo::RefPtr<Cairo::ImageSurface> get_frame() const { return {}; }
+  virtual void toggle_fullscreen() {}
+  // Hands pending window-system input to the key handlers. Returns false once
+  // the user has closed the window.
+  virtual bool poll_events() { return true; }
+  // True when input only arrives through poll_events, so something has to
+  // keep calling it even while the game is idle
+  virtual bool needs_polling() const { return false; }
+};
+
+// The original path: frames are painted in the DrawingArea's draw handler
+class GtkRenderer : public Renderer {
+private:
+  Gtk::Window &window;
+  Gtk::DrawingArea &area;
+
+public:
+  GtkRenderer(Gtk::Window &window, Gtk::DrawingArea &area);
+
+  const char *get_name() const override { return "gtk"; }
+  bool initialize() override { return true; }
+  bool draws_in_widget() const override { return true; }
+  void request_frame() override;
+  void get_size(int &width, int &height) const override;
+  void toggle_fullscreen() override;
+};
+
+// Draws into an ImageSurface in memory. Used on its own for headless runs.
+class OffscreenRenderer : public Renderer {
+protected:
+  Cairo::RefPtr<Cairo::ImageSurface> surface;
+  int width;
+  int height;
+
+  void resize_surface(int new_width, int new_height);
+  virtual void present() {}
+
+public:
+  OffscreenRenderer(int width, int height);
+
+  const char *get_name() const override { return "headless"; }
+  bool initialize() override { return true; }
+  void request_frame() override;
+  void get_size(int &out_width, int &out_height) const override;
+  Cairo::RefPtr<Cairo::ImageSurface> get_frame() const override {
+    return surface;
+  }
 };
 
-class WillyGame : public Gtk::Window {
+// Shows the offscreen frame in an SDL2 window through a streaming texture
+class SdlRenderer : public OffscreenRenderer {
 private:
+  SDL_Window *sdl_window = nullptr;
+  SDL_Renderer *sdl_renderer = nullptr;
+  SDL_Texture *texture = nullptr;
+  bool video_initialized = false;
+  bool fullscreen = false;
+
+  bool create_texture();
+  void handle_key(const SDL_KeyboardEvent &key);
+
+protected:
+  void present() override;
+
+public:
+  SdlRenderer(int width, int height);
+  ~SdlRenderer();
+
+  const char *get_name() const override { return "sdl"; }
+  bool initialize() override;
+  void toggle_fullscreen() override;
+  bool poll_events() override;
+  bool needs_polling() const override { return true; }
+};
+
+// The window the game is shown in. SDL runs keep it hidden as the
+// application's main window; headless runs have none, so they never need a
+// display.
+class GameWindow : public Gtk::Window {
+public:
+  Gtk::Box vbox{Gtk::ORIENTATION_VERTICAL};
   Gtk::DrawingArea drawing_area;
-  Gtk::Box vbox;
   Gtk::MenuBar menubar;
   Gtk::Label status_bar;
+  // The game paints the whole window itself
+  std::function<bool(const Cairo::RefPtr<Cairo::Context> &)> on_paint;
+  std::function<void()> on_hidden;
+
+protected:
+  bool on_draw(const Cairo::RefPtr<Cairo::Context> &cr) override {
+    return on_paint ? on_paint(cr) : Gtk::Window::on_draw(cr);
+  }
+  void on_hide() override {
+    if (on_hidden) {
+      on_hidden();
+    }
+    Gtk::Window::on_hide();
+  }
+};
+
+class WillyGame : public sigc::trackable {
+private:
+  std::unique_ptr<GameWindow> game_window; // Null for headless runs
+  Glib::RefPtr<Glib::MainLoop> headless_loop;
 
   std::unique_ptr<SpriteLoader> sprite_loader;
   std::unique_ptr<LevelLoader> level_loader;
   std::unique_ptr<HighScoreManager> score_manager;
+  std::unique_ptr<Renderer> renderer;
+  int frames_rendered = 0;
+  std::unique_ptr<FrameCapture> frame_capture;
+  std::map<std::string, std::unique_ptr<BitmapFont>> font_cache;
+
+  // Screens that only change on resize, colour change or a new high score
+  // are drawn once into a surface and blitted from there
+  struct ScreenCache {
+    Cairo::RefPtr<Cairo::ImageSurface> surface;
+    std::string key;
+  };
+  ScreenCache intro_cache;
+  ScreenCache high_score_cache;
+  IndexedFramebuffer framebuffer;
+  Cairo::RefPtr<Cairo::ImageSurface> frame_surface;
+
+  // The GTK backend captures through a second, offscreen target. It has no
+  // window chrome and stays at base size, so it gets its own viewport and
+  // surfaces, swapped in for the length of each capture.
+  struct TargetState {
+    Viewport viewport;
+    ScreenCache intro_cache;
+    ScreenCache high_score_cache;
+    Cairo::RefPtr<Cairo::ImageSurface> frame_surface;
+  };
+  std::unique_ptr<OffscreenRenderer> capture_target;
+  TargetState capture_state;
+  bool drawing_capture = false;
   std::pair<int, int>
       previous_willy_position; // Track where Willy was last frame
   // Game state
@@ -245,8 +939,7 @@ private:
   int fps;
   int frame_count;
 
-  double current_scale_x = 1.0;
-  double current_scale_y = 1.0;
+  Viewport viewport;
   int base_game_width;
   int base_game_height;
   bool maintain_aspect_ratio = true;
@@ -254,17 +947,78 @@ private:
   std::string current_level;
   std::vector<Ball> balls;
 
-  std::set<std::string> keys_pressed;
+  // Keys as the game logic sees them. A key pressed since the last tick
+  // counts as down for that tick even if it has already been released, so a
+  // quick tap still moves Willy.
+  KeySet keys_held;
+  KeySet keys_tapped;
   std::random_device rd;
   std::mt19937 gen;
 
   sigc::connection timer_connection;
 
+  // The tick timer only runs while something on screen can change; static
+  // screens, hidden windows and lost focus leave the main loop asleep until
+  // input arrives
+  enum class TickMode { STOPPED, POLLING, RUNNING };
+  TickMode tick_mode = TickMode::STOPPED;
+
+  // In the GTK window the display's frame clock drives drawing and the
+  // simulation catches up in fixed steps of 1/fps. Sprites are drawn
+  // frame_interpolation of the way from where the last step started.
+  guint frame_callback_id = 0;
+  FramePacer pacer;
+  double frame_interpolation = 1.0;
+  std::pair<int, int> willy_interp_from{23, 7};
+
+  // Drawing reads the game through *view. Tile changes bump grid_version so
+  // snapshots know when to recopy the grid.
+  GameSnapshot live_view;
+  const GameSnapshot *view = &live_view;
+  int grid_version = 0;
+
+  // Input waits here, oldest first, until the game logic applies it. While
+  // the game is running that happens at the start of the next tick.
+  SpscQueue<InputEvent, 256> input_queue;
+
+  // --sim-thread: the game logic runs on sim_thread at fps and publishes
+  // snapshots; snapshot_ready wakes an idle GTK thread when one arrives
+  TripleBuffer<GameSnapshot> snapshots;
+  std::thread sim_thread;
+  std::atomic<bool> sim_stopping{false};
+  std::atomic<bool> main_idle{true};
+  std::mutex sim_mutex;
+  std::condition_variable sim_wake;
+  Glib::Dispatcher snapshot_ready;
+
+  // --gamepad: controller input arrives from its own thread and is handed
+  // over through gamepad_ready
+  std::unique_ptr<GamepadInput> gamepad;
+  Glib::Dispatcher gamepad_ready;
+
+  // Startup: the loaders are built in the background while a splash shows.
+  // Nothing reads the game state until loading is false.
+  bool loading = false;
+  gint64 loading_started = 0;
+  std::future<std::unique_ptr<LevelLoader>> levels_loading;
+  std::future<std::unique_ptr<SpriteLoader>> sprites_loading;
+  std::future<void> scores_loading;
+  // Counts the level and sprite tasks that are done. A task emits
+  // loading_progress before its future is ready, so this says when to wait.
+  std::atomic<int> loading_tasks_done{0};
+  Glib::Dispatcher loading_progress;
+  bool window_active = true;
+  bool quitting = false;
+
   std::string continuous_direction; // For continuous movement
   bool moving_continuously;
-  bool up_pressed = false;
+  bool up_pressed = false; // Held by the mouse; keys are in keys_held
   bool down_pressed = false;
 
+  // How long input waited in the queue before the game applied it
+  gint64 input_latency_total = 0;
+  int input_events_applied = 0;
+
   // High score entry state
   std::string name_input;
   bool mouse_button_held = false;
@@ -273,13 +1027,18 @@ private:
   bool mouse_up_held = false;
   bool mouse_down_held = false;
   int life_adder;
+  int flash_ticks_left = 0; // Death flash still showing for this many ticks
+  bool flash_strobe = false;
   void show_control_panel();
 
 public:
   WillyGame();
   ~WillyGame();
+  Gtk::Window &get_game_window() { return *game_window; }
+  // Headless runs only: ticks the game until it quits
+  void run_headless();
   void on_window_resize();
-  void calculate_scaling_factors();
+  bool update_viewport();
   void new_game();
   void reset_level();
   void quit_game();
@@ -298,6 +1057,28 @@ private:
   void load_level(const std::string &level_name);
   bool on_key_press(GdkEventKey *event);
   bool on_key_release(GdkEventKey *event);
+  void dispatch_key_press(guint keyval, guint state, gint64 time);
+  void dispatch_key_release(guint keyval, guint state, gint64 time);
+  void on_gamepad_input();
+  void start_loading();
+  void wait_for_loading();
+  void on_loading_progress();
+  void finish_loading();
+  void send_input(const InputEvent &event);
+  void handle_input(const InputEvent &event);
+  void drain_input();
+  bool key_down(guint keyval) const;
+  void handle_key_press(guint keyval, guint state);
+  void handle_key_release(guint keyval);
+  void handle_button_press(int button, double x, double y);
+  void handle_button_release(int button);
+  void reset_game();
+  void fill_snapshot(GameSnapshot &snapshot);
+  bool refresh_view();
+  void publish_snapshot();
+  void start_sim_thread();
+  void stop_sim_thread();
+  void sim_thread_loop();
   void start_game();
   void jump();
   std::string get_tile(int row, int col);
@@ -313,18 +1094,49 @@ private:
   void game_over();
   void update_status_bar();
   bool game_tick();
+  bool on_frame_clock(const Glib::RefPtr<Gdk::FrameClock> &clock);
+  void save_interpolation_start();
+  void simulate_tick();
+  bool finish_tick();
+  void start_tick_timer();
+  void stop_tick_timer();
+  void schedule_next_tick();
+  bool on_tick_deadline();
+  bool wants_ticks() const;
+  void update_tick_timer();
+  bool poll_while_idle();
+  void wake();
+  void set_window_active(bool active);
+  bool on_focus_change(GdkEventFocus *event);
+  bool on_window_state_change(GdkEventWindowState *event);
+  void pause_game();
+  void resume_game();
+  void capture_frame();
+  void swap_capture_state();
+  void on_window_hidden();
   bool on_draw(const Cairo::RefPtr<Cairo::Context> &cr);
+  void render_frame(const Cairo::RefPtr<Cairo::Context> &cr);
+  BitmapFont &get_font(const std::string &family, int point_size);
+  void draw_cached_screen(const Cairo::RefPtr<Cairo::Context> &cr,
+                          ScreenCache &cache, const std::string &key,
+                          const FrameDrawer &draw);
+  void get_render_size(int &width, int &height);
+  void draw_splash_screen(const Cairo::RefPtr<Cairo::Context> &cr);
   void draw_intro_screen(const Cairo::RefPtr<Cairo::Context> &cr);
   void draw_game_screen(const Cairo::RefPtr<Cairo::Context> &cr);
+  void compose_game_frame();
+  double interpolate_cell(int from, int to) const;
   void draw_game_over_screen(const Cairo::RefPtr<Cairo::Context> &cr);
+  void draw_paused_overlay(const Cairo::RefPtr<Cairo::Context> &cr);
   void draw_high_score_entry_screen(const Cairo::RefPtr<Cairo::Context> &cr);
   void draw_high_score_display_screen(const Cairo::RefPtr<Cairo::Context> &cr);
   std::pair<int, int> find_ballpit_position();
   bool check_movement_collision(int old_row, int old_col, int new_row,
                                 int new_col);
-  std::unique_ptr<SoundManager> sound_manager;
+  std::unique_ptr<AudioBackend> sound_manager;
   void flash_death_screen();
   void flash_death_screen_seizure();
+  void draw_death_flash(const Cairo::RefPtr<Cairo::Context> &cr);
 };
 
 class WillyApplication : public Gtk::Application {
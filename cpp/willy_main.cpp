@@ -3,6 +3,24 @@
 
 extern GameOptions game_options;
 
+// Long options without a single-letter form
+enum LongOnlyOption {
+  OPT_SPRITE_FILTER = 256,
+  OPT_BACKEND,
+  OPT_FRAMES,
+  OPT_CAPTURE_DIR,
+  OPT_CAPTURE_EVERY,
+  OPT_CAPTURE_FORMAT,
+  OPT_EXPORT_VIDEO,
+  OPT_SIM_THREAD,
+  OPT_GAMEPAD,
+  OPT_GAMEPAD_DEADZONE,
+  OPT_GAMEPAD_BIND,
+  OPT_AUDIO_LATENCY,
+  OPT_AUDIO_RATE,
+  OPT_SOUND
+};
+
 void print_help(const char *program_name) {
   std::cout << "Willy the Worm - C++ GTK Edition\n\n";
   std::cout << "Usage: " << program_name << " [OPTIONS]\n\n";
@@ -18,10 +36,43 @@ void print_help(const char *program_name) {
   std::cout << "  -m                Enable mouse support\n";
   std::cout << "  -s                Start with sound disabled\n";
   std::cout << "  -S SCALE          Set scale factor (default: 3)\n";
+  std::cout << "  --sprite-filter=FILTER\n"
+               "                    Sprite upscaling: nearest, hq2x or hq4x "
+               "(default: nearest)\n";
+  std::cout << "  --backend=BACKEND Renderer: gtk, sdl or headless (default: "
+               "gtk)\n"
+               "                    headless draws in memory and needs no "
+               "display\n";
+  std::cout << "  --frames=N        Quit after N frames (for headless runs)\n";
+  std::cout << "  --capture-dir=DIR Save rendered frames as images in DIR\n";
+  std::cout << "  --capture-every=N Only save every Nth frame (default: 1)\n";
+  std::cout << "  --capture-format=FORMAT\n"
+               "                    Image format: png or ppm (default: png)\n";
+  std::cout << "  --export-video=FILE\n"
+               "                    Stream every frame to a .y4m video\n";
+  std::cout << "  --sim-thread      Run the game logic on its own thread\n";
+  std::cout << "  --gamepad         Play with a game controller as well\n";
+  std::cout << "  --gamepad-deadzone=PERCENT\n"
+               "                    Stick travel to ignore (default: 35)\n";
+  std::cout << "  --gamepad-bind=INPUT=KEY[,INPUT=KEY...]\n"
+               "                    Change controller bindings, e.g. "
+               "x=space,leftx-=none\n";
+  std::cout << "  --sound=MODE      Sound effects: files, synth, none or "
+               "record:FILE\n"
+               "                    (default: files, or none when headless)\n";
+  std::cout << "  --audio-latency=LATENCY\n"
+               "                    Mixer buffer: low (48 kHz, 256 frames), "
+               "normal\n"
+               "                    or a frame count (default: normal)\n";
+  std::cout << "  --audio-rate=HZ   Mixer sample rate (default: 22050, or "
+               "48000 for low)\n";
   std::cout << "  -h, --help        Show this help message\n\n";
   std::cout << "Controls:\n";
   std::cout << "  Arrow Keys        Move Willy (or WASD with -w option)\n";
   std::cout << "  Space             Jump\n";
+  std::cout << "  Gamepad (with --gamepad): D-pad or left stick to move, A/B "
+               "to jump,\n"
+               "                    Start for Enter, Back to pause\n";
   std::cout << "  Mouse (with -m):  Hold mouse button relative to Willy:\n";
   std::cout << "    - Hold above    Keep moving up (climb ladder)\n";
   std::cout << "    - Hold below    Keep moving down (climb ladder)\n";
@@ -48,10 +99,26 @@ bool parse_command_line(int argc, char *argv[]) {
       {"mouse", no_argument, nullptr, 'm'},
       {"no-sound", no_argument, nullptr, 's'},
       {"scale", required_argument, nullptr, 'S'},
+      {"sprite-filter", required_argument, nullptr, OPT_SPRITE_FILTER},
+      {"backend", required_argument, nullptr, OPT_BACKEND},
+      {"frames", required_argument, nullptr, OPT_FRAMES},
+      {"capture-dir", required_argument, nullptr, OPT_CAPTURE_DIR},
+      {"capture-every", required_argument, nullptr, OPT_CAPTURE_EVERY},
+      {"capture-format", required_argument, nullptr, OPT_CAPTURE_FORMAT},
+      {"export-video", required_argument, nullptr, OPT_EXPORT_VIDEO},
+      {"sim-thread", no_argument, nullptr, OPT_SIM_THREAD},
+      {"gamepad", no_argument, nullptr, OPT_GAMEPAD},
+      {"gamepad-deadzone", required_argument, nullptr, OPT_GAMEPAD_DEADZONE},
+      {"gamepad-bind", required_argument, nullptr, OPT_GAMEPAD_BIND},
+      {"sound", required_argument, nullptr, OPT_SOUND},
+      {"audio-latency", required_argument, nullptr, OPT_AUDIO_LATENCY},
+      {"audio-rate", required_argument, nullptr, OPT_AUDIO_RATE},
       {nullptr, 0, nullptr, 0}};
 
   int option_index = 0;
   int c;
+  int audio_rate = 0; // --audio-rate wins over the preset, in any order
+  bool sound_given = false;
 
   while ((c = getopt_long(argc, argv, "hl:L:b:wfF:msS:", long_options,
                           &option_index)) != -1) {
@@ -121,6 +188,147 @@ bool parse_command_line(int argc, char *argv[]) {
       game_options.sound_enabled = false;
       break;
 
+    case OPT_SPRITE_FILTER:
+      if (!parse_sprite_filter(optarg, game_options.sprite_filter)) {
+        std::cerr << "Error: Sprite filter must be nearest, hq2x or hq4x\n";
+        return false;
+      }
+      break;
+
+    case OPT_BACKEND:
+      if (!parse_render_backend(optarg, game_options.backend)) {
+        std::cerr << "Error: Backend must be gtk, sdl or headless\n";
+        return false;
+      }
+      break;
+
+    case OPT_FRAMES:
+      try {
+        game_options.max_frames = std::stoi(optarg);
+      } catch (const std::exception &) {
+        game_options.max_frames = -1;
+      }
+      if (game_options.max_frames < 1) {
+        std::cerr << "Error: Invalid value for frames: " << optarg << "\n";
+        return false;
+      }
+      break;
+
+    case OPT_CAPTURE_DIR:
+      game_options.capture_dir = optarg;
+      break;
+
+    case OPT_CAPTURE_EVERY:
+      try {
+        game_options.capture_every = std::stoi(optarg);
+      } catch (const std::exception &) {
+        game_options.capture_every = 0;
+      }
+      if (game_options.capture_every < 1) {
+        std::cerr << "Error: Invalid value for capture-every: " << optarg
+                  << "\n";
+        return false;
+      }
+      break;
+
+    case OPT_CAPTURE_FORMAT:
+      game_options.capture_format = optarg;
+      if (game_options.capture_format != "png" &&
+          game_options.capture_format != "ppm") {
+        std::cerr << "Error: Capture format must be png or ppm\n";
+        return false;
+      }
+      break;
+
+    case OPT_EXPORT_VIDEO:
+      game_options.export_video = optarg;
+      break;
+
+    case OPT_SIM_THREAD:
+      game_options.sim_thread = true;
+      break;
+
+    case OPT_GAMEPAD:
+      game_options.gamepad = true;
+      break;
+
+    case OPT_GAMEPAD_DEADZONE:
+      try {
+        game_options.gamepad_deadzone = std::stoi(optarg);
+      } catch (const std::exception &) {
+        game_options.gamepad_deadzone = -1;
+      }
+      if (game_options.gamepad_deadzone < 1 ||
+          game_options.gamepad_deadzone > 95) {
+        std::cerr << "Error: Gamepad deadzone must be between 1 and 95\n";
+        return false;
+      }
+      break;
+
+    case OPT_GAMEPAD_BIND: {
+      // Check the names now rather than when the game starts
+      std::vector<GamepadInput::Binding> bindings =
+          GamepadInput::default_bindings();
+      if (!GamepadInput::parse_bindings(optarg, bindings)) {
+        return false;
+      }
+      if (!game_options.gamepad_bindings.empty()) {
+        game_options.gamepad_bindings += ",";
+      }
+      game_options.gamepad_bindings += optarg;
+      game_options.gamepad = true;
+      break;
+    }
+
+    case OPT_SOUND:
+      if (!parse_sound_mode(optarg, game_options.sound_mode,
+                            game_options.sound_record_file)) {
+        std::cerr << "Error: Sound must be files, synth, none or record:FILE\n";
+        return false;
+      }
+      sound_given = true;
+      break;
+
+    case OPT_AUDIO_LATENCY: {
+      std::string latency = optarg;
+      if (latency == "low") {
+        game_options.audio_rate = 48000;
+        game_options.audio_buffer = 256;
+        break;
+      }
+      if (latency == "normal") {
+        game_options.audio_rate = 22050;
+        game_options.audio_buffer = 1024;
+        break;
+      }
+      int frames = 0;
+      try {
+        frames = std::stoi(latency);
+      } catch (const std::exception &) {
+        frames = 0;
+      }
+      // Some audio drivers only take powers of two
+      if (frames < 64 || frames > 8192 || (frames & (frames - 1)) != 0) {
+        std::cerr << "Error: Audio latency must be low, normal or a power of "
+                     "two from 64 to 8192 frames\n";
+        return false;
+      }
+      game_options.audio_buffer = frames;
+      break;
+    }
+
+    case OPT_AUDIO_RATE:
+      try {
+        audio_rate = std::stoi(optarg);
+      } catch (const std::exception &) {
+        audio_rate = -1;
+      }
+      if (audio_rate < 8000 || audio_rate > 192000) {
+        std::cerr << "Error: Audio rate must be between 8000 and 192000\n";
+        return false;
+      }
+      break;
+
     case '?':
       return false; // getopt_long already prints error messages
 
@@ -130,6 +338,14 @@ bool parse_command_line(int argc, char *argv[]) {
     }
   }
 
+  if (audio_rate > 0) {
+    game_options.audio_rate = audio_rate;
+  }
+  // Headless runs don't open an audio device unless asked to
+  if (!sound_given && game_options.backend == RenderBackend::HEADLESS) {
+    game_options.sound_mode = SoundMode::NONE;
+  }
+
   // Check for unexpected arguments
   if (optind < argc) {
     std::cerr << "Error: Unexpected argument: " << argv[optind] << "\n";